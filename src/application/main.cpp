@@ -5,14 +5,20 @@
  */
 
 #include "application_settings.h"
+#include "trace.h"
 #include <QtWidgets>
 #include <chrono>
+#include <memory>
 #include <thread>
 
 using namespace std::chrono_literals;
 
 int main(int argc, char** argv)
 {
+    // Set PROJECT_LIBRARY_TRACE=<file> to write a startup trace that opens in chrome://tracing or ui.perfetto.dev
+    project_library::traceThreadName("main");
+    std::unique_ptr<project_library::TraceSpan> startup(new project_library::TraceSpan("startup", "application"));
+
     QApplication app(argc, argv);
 
     QMainWindow mainWindow;
@@ -20,18 +26,32 @@ int main(int argc, char** argv)
 
     QPixmap pixmap(":images/splash.png");
     QSplashScreen splash(pixmap, Qt::WindowStaysOnTopHint);
-    splash.show();
-    splash.showMessage("Loading settings", Qt::AlignHCenter | Qt::AlignBottom);
+    {
+        project_library::TraceSpan span("show splash", "application");
+        splash.show();
+        splash.showMessage("Loading settings", Qt::AlignHCenter | Qt::AlignBottom);
+    }
     ApplicationSettings settings;
 
-    std::thread loadSettings([&mainWindow, &splash, &settings]() {
+    std::thread loadSettings([&mainWindow, &splash, &settings, &startup]() {
+        project_library::traceThreadName("settings loader");
         std::this_thread::sleep_for(1000ms);
-        settings.load();
+        {
+            project_library::TraceSpan span("load settings", "application");
+            settings.load();
+        }
         QMetaObject::invokeMethod(&splash, "showMessage", Qt::QueuedConnection, Q_ARG(QString, "Loaded settings"),
                                   Q_ARG(int, (Qt::AlignHCenter | Qt::AlignBottom)));
         std::this_thread::sleep_for(1000ms);
-        QMetaObject::invokeMethod(&mainWindow, "show", Qt::QueuedConnection);
-        QMetaObject::invokeMethod(&splash, "hide", Qt::QueuedConnection);
+        project_library::traceInstant("hand-off to main window", "application");
+        QMetaObject::invokeMethod(
+            &splash,
+            [&mainWindow, &splash, &startup]() {
+                mainWindow.show();
+                splash.hide();
+                startup.reset();
+            },
+            Qt::QueuedConnection);
     });
 
     auto ret = app.exec();
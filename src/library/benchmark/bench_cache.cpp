@@ -0,0 +1,69 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Start time with and without the pre-parsed copy of the settings files.
+ * Usage: bench_cache [keys]
+ */
+
+#include "Poco/File.h"
+#include "benchmark.h"
+#include "settings.h"
+#include "settings_stream.h"
+
+using namespace project_library;
+
+namespace
+{
+
+void run(const std::string& filename, Settings::Format format, int keys)
+{
+    auto path = "appdata/" + filename;
+    auto writer = openWriter(path, format);
+    for (int i = 0; i < keys; ++i)
+    {
+        writer->write("section" + std::to_string(i / 100) + ".key" + std::to_string(i % 100),
+                      "a moderately long value number " + std::to_string(i));
+    }
+    writer->close();
+    std::cout << filename << ": " << Poco::File(path).getSize() / 1024 << " KiB\n";
+
+    constexpr int rounds = 5;
+    double cold = 0;
+    double warm = 0;
+    auto before = Settings::cacheStatistics();
+    for (int i = 0; i < rounds; ++i)
+    {
+        Poco::File cache(path + ".cache");
+        if (cache.exists())
+        {
+            cache.remove();
+        }
+        // Every start is a new instance, the registry does not keep the values between them
+        cold += benchmark::measureOnce("  start, no cache (parse + store)", [&filename, format]() {
+            Settings settings(filename, "appdata", false, format);
+            settings.load();
+        });
+        warm += benchmark::measureOnce("  start, cache hit", [&filename, format]() {
+            Settings settings(filename, "appdata", false, format);
+            settings.load();
+        });
+    }
+    auto after = Settings::cacheStatistics();
+    std::cout << "  mean cold " << cold / rounds << " ms, mean warm " << warm / rounds << " ms, "
+              << after.hits - before.hits << " hits, " << after.misses - before.misses << " misses\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int keys = argc > 1 ? std::stoi(argv[1]) : 200000;
+    Poco::File("appdata").createDirectories();
+
+    run("bench_cache.json", Settings::Format::JSON, keys);
+    run("bench_cache.xml", Settings::Format::XML, keys);
+    run("bench_cache.properties", Settings::Format::PropertyFile, keys);
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Load time of plain and gzip compressed settings files, with cold and warm page cache.
+ * Usage: bench_compression [keys]
+ */
+
+#include "Poco/File.h"
+#include "benchmark.h"
+#include "settings.h"
+#include "settings_stream.h"
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace project_library;
+
+namespace
+{
+
+/**
+ * Drops the file from the page cache, so the next load reads it from the disk
+ * @return false if the platform can not drop the cache
+ */
+bool dropCache(const std::string& path)
+{
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    ::fdatasync(fd);
+    bool dropped = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return dropped;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void generate(const std::string& path, Settings::Format format, int keys)
+{
+    auto writer = openWriter(path, format);
+    for (int i = 0; i < keys; ++i)
+    {
+        writer->write("section" + std::to_string(i / 100) + ".key" + std::to_string(i % 100),
+                      "a moderately long value number " + std::to_string(i));
+    }
+    writer->close();
+}
+
+void run(const std::string& filename, Settings::Format format, int keys)
+{
+    auto path = "appdata/" + filename;
+    generate(path, format, keys);
+    std::cout << filename << ": " << Poco::File(path).getSize() / 1024 << " KiB\n";
+
+    constexpr int rounds = 5;
+    double cold = 0;
+    double warm = 0;
+    bool canDrop = true;
+    for (int i = 0; i < rounds; ++i)
+    {
+        canDrop = dropCache(path) && canDrop;
+        cold += benchmark::measureOnce("  load, cold cache", [&filename, format]() {
+            Settings settings(filename, "appdata", false, format);
+            settings.load();
+        });
+        warm += benchmark::measureOnce("  load, warm cache", [&filename, format]() {
+            Settings settings(filename, "appdata", false, format);
+            settings.load();
+        });
+    }
+    std::cout << "  mean cold " << cold / rounds << " ms" << (canDrop ? "" : " (page cache not dropped)")
+              << ", mean warm " << warm / rounds << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int keys = argc > 1 ? std::stoi(argv[1]) : 200000;
+    // The pre-parsed copy would replace the parsing that this benchmark measures
+    benchmark::disableSettingsCache();
+    Poco::File("appdata").createDirectories();
+
+    run("bench_compression.json", Settings::Format::JSON, keys);
+    run("bench_compression.json.gz", Settings::Format::JSON, keys);
+    run("bench_compression.xml", Settings::Format::XML, keys);
+    run("bench_compression.xml.gz", Settings::Format::XML, keys);
+    return 0;
+}
@@ -0,0 +1,60 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Cost of loading the settings from the local configuration daemon compared with loading them from a file.
+ */
+
+#include "../test/config_daemon_stub.h"
+#include "Poco/File.h"
+#include "Poco/Timestamp.h"
+#include "benchmark.h"
+#include "settings.h"
+#include <cstdlib>
+
+using namespace project_library;
+
+int main()
+{
+    constexpr int keys = 1000;
+    constexpr std::size_t iterations = 2000;
+
+    // A changed file is parsed, the writing of its pre-parsed copy has no daemon counterpart
+    benchmark::disableSettingsCache();
+    ConfigDaemonStub daemon;
+#ifdef _WIN32
+    _putenv_s(CONFIG_DAEMON_ENVIRONMENT_VARIABLE, daemon.address().c_str());
+#else
+    setenv(CONFIG_DAEMON_ENVIRONMENT_VARIABLE, daemon.address().c_str(), 1);
+#endif
+
+    Settings file("bench_daemon.prop", "appdata", false, Settings::Format::PropertyFile);
+    for (int i = 0; i < keys; ++i)
+    {
+        file.setString("section.key" + std::to_string(i), "value" + std::to_string(i));
+        daemon.set("bench_daemon", "section.key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    file.save();
+    Settings remote("bench_daemon", "", false, Settings::Format::Daemon);
+    remote.load();
+
+    benchmark::measure("file load, unchanged", iterations, [&file](std::size_t) { file.load(); });
+    benchmark::measure("daemon load, unchanged (304)", iterations, [&remote](std::size_t) { remote.load(); });
+
+    Poco::File path("appdata/bench_daemon.prop");
+    benchmark::measure("file load, changed", iterations, [&file, &path](std::size_t) {
+        path.setLastModified(Poco::Timestamp());
+        file.load();
+    });
+    benchmark::measure("daemon load, changed", iterations, [&remote, &daemon](std::size_t i) {
+        daemon.set("bench_daemon", "section.key0", std::to_string(i));
+        remote.load();
+    });
+
+    benchmark::measure("daemon save, one change", iterations, [&remote](std::size_t i) {
+        remote.setString("section.key1", std::to_string(i));
+        remote.save();
+    });
+    return 0;
+}
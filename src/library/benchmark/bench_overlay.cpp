@@ -0,0 +1,61 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Cost of creating per-request overlays and of reading through them.
+ */
+
+#include "benchmark.h"
+#include "settings.h"
+#include <vector>
+
+using namespace project_library;
+
+int main()
+{
+    constexpr int keys = 10000;
+    constexpr std::size_t iterations = 200000;
+
+    Settings parent("bench_overlay.json", "appdata", false, Settings::Format::JSON);
+    for (int i = 0; i < keys; ++i)
+    {
+        parent.setString("section.key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    std::vector<std::string> names;
+    for (int i = 0; i < keys; ++i)
+    {
+        names.push_back("section.key" + std::to_string(i));
+    }
+
+    benchmark::measure("overlay creation", iterations, [&parent](std::size_t) {
+        auto child = parent.overlay();
+        benchmark::doNotOptimize(child);
+    });
+
+    benchmark::measure("overlay creation + 4 overrides", iterations, [&parent, &names](std::size_t i) {
+        auto child = parent.overlay();
+        for (std::size_t k = 0; k < 4; ++k)
+        {
+            child->setString(names[(i + k) % keys], "override");
+        }
+        benchmark::doNotOptimize(child);
+    });
+
+    auto child = parent.overlay();
+    for (int i = 0; i < keys; i += 1000)
+    {
+        child->setString(names[i], "override");
+    }
+
+    benchmark::measure("parent lookup", iterations, [&parent, &names](std::size_t i) {
+        benchmark::doNotOptimize(parent.getString(names[i % keys]));
+    });
+    benchmark::measure("overlay lookup, overridden key", iterations, [&child, &names](std::size_t i) {
+        benchmark::doNotOptimize(child->getString(names[(i * 1000) % keys]));
+    });
+    benchmark::measure("overlay lookup, parent key", iterations, [&child, &names](std::size_t i) {
+        benchmark::doNotOptimize(child->getString(names[(i * 1000 + 1) % keys]));
+    });
+    return 0;
+}
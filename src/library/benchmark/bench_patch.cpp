@@ -0,0 +1,64 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Cost of applying a small patch in place against a full load of the changed file.
+ * Usage: bench_patch [keys]
+ */
+
+#include "Poco/File.h"
+#include "benchmark.h"
+#include "settings.h"
+#include "settings_patch.h"
+#include "settings_stream.h"
+
+using namespace project_library;
+
+namespace
+{
+
+void generate(const std::string& path, int keys, int changed)
+{
+    auto writer = openWriter(path, Settings::Format::JSON);
+    for (int i = 0; i < keys; ++i)
+    {
+        auto value = i < changed ? "updated value " : "value ";
+        writer->write("section" + std::to_string(i / 1000) + ".key" + std::to_string(i % 1000),
+                      value + std::to_string(i));
+    }
+    writer->close();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int keys = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    constexpr int changed = 3;
+    Poco::File("appdata").createDirectories();
+
+    generate("appdata/bench_patch_old.json", keys, 0);
+    generate("appdata/bench_patch_new.json", keys, changed);
+
+    SettingsPatch patch;
+    benchmark::measureOnce("diff files", [&patch]() {
+        patch = diff("appdata/bench_patch_old.json", "appdata/bench_patch_new.json", Settings::Format::JSON);
+    });
+    auto serialized = patch.serialize();
+    std::cout << "patch: " << patch.size() << " changes, " << serialized.size() << " bytes\n";
+
+    // Nothing else uses the new file and there is no pre-parsed copy, so the load parses it
+    benchmark::disableSettingsCache();
+    benchmark::measureOnce("full load of the new file", []() {
+        Settings settings("bench_patch_new.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+    });
+
+    Settings settings("bench_patch_old.json", "appdata", false, Settings::Format::JSON);
+    settings.load();
+    benchmark::measureOnce("parse + apply patch", [&settings, &serialized]() {
+        settings.apply(SettingsPatch::parse(serialized));
+    });
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Time until the first and the last startup key are read, with and without the access profile of a previous start.
+ * The settings use the filesystem format, every value is a file whose page cache is dropped before each start.
+ * Usage: bench_profile [keys] [startup keys]
+ */
+
+#include "Poco/File.h"
+#include "benchmark.h"
+#include "settings.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace project_library;
+
+namespace
+{
+
+void dropCache(const std::string& path)
+{
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+std::string dataFile(const std::string& key)
+{
+    auto path = std::string("appdata/bench_profile/");
+    for (auto c : key)
+    {
+        path += c == '.' ? '/' : c;
+    }
+    return path + "/data";
+}
+
+void start(const char* name, const std::vector<std::string>& startupKeys)
+{
+    for (const auto& key : startupKeys)
+    {
+        dropCache(dataFile(key));
+    }
+    using Clock = std::chrono::steady_clock;
+    auto begin = Clock::now();
+    Settings settings("bench_profile", "appdata", false, Settings::Format::Filesystem);
+    settings.load();
+    // The rest of the startup, e.g. creating the main window, before the settings are needed
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    benchmark::doNotOptimize(settings.getString(startupKeys.front()));
+    std::chrono::duration<double, std::milli> first = Clock::now() - begin;
+    for (const auto& key : startupKeys)
+    {
+        benchmark::doNotOptimize(settings.getString(key));
+    }
+    std::chrono::duration<double, std::milli> last = Clock::now() - begin;
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+              << "first key " << first.count() << " ms, last key " << last.count() << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int keys = argc > 1 ? std::stoi(argv[1]) : 20000;
+    int startup = argc > 2 ? std::stoi(argv[2]) : 300;
+
+    std::vector<std::string> startupKeys;
+    {
+        Settings settings("bench_profile", "appdata", false, Settings::Format::Filesystem);
+        for (int i = 0; i < keys; ++i)
+        {
+            auto key = "section" + std::to_string(i % 97) + ".key" + std::to_string(i);
+            settings.setString(key, "value " + std::to_string(i));
+            if (i % (keys / startup) == 0)
+            {
+                startupKeys.push_back(key);
+            }
+        }
+
+        Poco::File profile("appdata/bench_profile.profile");
+        if (profile.exists())
+        {
+            profile.remove();
+        }
+        settings.recordAccessProfile();
+        for (const auto& key : startupKeys)
+        {
+            settings.getString(key);
+        }
+        settings.saveAccessProfile();
+        profile.renameTo("appdata/bench_profile.profile.saved");
+    }
+
+    constexpr int rounds = 5;
+    for (int i = 0; i < rounds; ++i)
+    {
+        start("without profile", startupKeys);
+        Poco::File("appdata/bench_profile.profile.saved").copyTo("appdata/bench_profile.profile");
+        start("with profile", startupKeys);
+        Poco::File("appdata/bench_profile.profile").remove();
+    }
+    return 0;
+}
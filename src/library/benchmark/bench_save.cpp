@@ -0,0 +1,77 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Save throughput of the streaming writers used by Settings::save(), next to the document serializers of Poco.
+ * Usage: bench_save [keys]
+ */
+
+#include "Poco/AutoPtr.h"
+#include "Poco/File.h"
+#include "Poco/Util/JSONConfiguration.h"
+#include "Poco/Util/PropertyFileConfiguration.h"
+#include "Poco/Util/XMLConfiguration.h"
+#include "benchmark.h"
+#include "settings.h"
+#include <fstream>
+
+using namespace project_library;
+
+namespace
+{
+
+void report(const std::string& path, double milliseconds)
+{
+    auto megabytes = static_cast<double>(Poco::File(path).getSize()) / 1e6;
+    std::cout << "  " << megabytes << " MB, " << megabytes / (milliseconds / 1000) << " MB/s\n";
+}
+
+template <typename Document> void run(const std::string& filename, Settings::Format format, int keys)
+{
+    auto path = "appdata/" + filename;
+    std::cout << filename << ", " << keys << " keys\n";
+    {
+        Settings settings(filename, "appdata", false, format);
+        for (int i = 0; i < keys; ++i)
+        {
+            auto section = "section" + std::to_string(i / 100) + ".key" + std::to_string(i % 100);
+            switch (i % 3)
+            {
+            case 0:
+                settings.setString(section, "a moderately long value number " + std::to_string(i));
+                break;
+            case 1:
+                settings.setInt(section, i);
+                break;
+            default:
+                settings.setDouble(section, i / 7.0);
+            }
+        }
+        auto elapsed = benchmark::measureOnce("  streaming writer, save", [&settings]() { settings.save(); });
+        report(path, elapsed);
+    }
+    {
+        Poco::AutoPtr<Document> document(new Document());
+        document->load(path);
+        auto copy = path + ".document";
+        auto elapsed = benchmark::measureOnce("  Poco document, save", [&document, &copy]() {
+            std::ofstream output(copy, std::ios::binary);
+            document->save(output);
+        });
+        report(copy, elapsed);
+        Poco::File(copy).remove();
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int keys = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    Poco::File("appdata").createDirectories();
+    run<Poco::Util::JSONConfiguration>("bench_save.json", Settings::Format::JSON, keys);
+    run<Poco::Util::XMLConfiguration>("bench_save.xml", Settings::Format::XML, keys);
+    run<Poco::Util::PropertyFileConfiguration>("bench_save.prop", Settings::Format::PropertyFile, keys);
+    return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Write throughput of the document and the sharded stores from 1 to 64 threads.
+ * Usage: bench_sharded [writes per thread]
+ */
+
+#include "benchmark.h"
+#include "settings.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace project_library;
+
+namespace
+{
+
+/**
+ * @return the writes per second of all the threads together
+ */
+double run(Settings& settings, int threads, int writes)
+{
+    std::vector<std::vector<std::string>> keys(threads);
+    for (int thread = 0; thread < threads; ++thread)
+    {
+        for (int i = 0; i < 64; ++i)
+        {
+            keys[thread].push_back("component" + std::to_string(thread) + ".counter" + std::to_string(i));
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> writers;
+    for (int thread = 0; thread < threads; ++thread)
+    {
+        writers.emplace_back([&settings, &keys, thread, writes]() {
+            const auto& names = keys[thread];
+            for (int i = 0; i < writes; ++i)
+            {
+                settings.setInt(names[i % names.size()], i);
+            }
+        });
+    }
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads * static_cast<double>(writes) / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int writes = argc > 1 ? std::stoi(argv[1]) : 200000;
+
+    Settings document("bench_sharded.json", "appdata", false, Settings::Format::JSON);
+    Settings sharded("bench_sharded.json", "appdata", false, Settings::Format::JSON, Settings::Store::Sharded);
+    std::cout << "threads      document (writes/s)      sharded (writes/s)\n";
+    for (int threads = 1; threads <= 64; threads *= 2)
+    {
+        auto documentRate = run(document, threads, writes);
+        auto shardedRate = run(sharded, threads, writes);
+        std::cout << std::setw(7) << threads << std::setw(24) << std::fixed << std::setprecision(0) << documentRate
+                  << std::setw(24) << shardedRate << '\n';
+    }
+
+    benchmark::measureOnce("sharded save (snapshot + write)", [&sharded]() { sharded.save(); });
+    return 0;
+}
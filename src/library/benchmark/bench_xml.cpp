@@ -0,0 +1,85 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ *
+ * Load time, lookup time and resident memory of an XML file in a DOM (Poco::Util::XMLConfiguration) and in the flat
+ * store used by Settings::Format::XML.
+ * Usage: bench_xml [keys]
+ */
+
+#include "Poco/AutoPtr.h"
+#include "Poco/File.h"
+#include "Poco/Util/XMLConfiguration.h"
+#include "benchmark.h"
+#include "settings.h"
+#include "settings_stream.h"
+#include <fstream>
+#include <vector>
+
+using namespace project_library;
+
+namespace
+{
+
+/**
+ * @return the resident set size of the process in KiB, 0 if the platform does not report it
+ */
+long residentKiB()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+        {
+            return std::stol(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int keys = argc > 1 ? std::stoi(argv[1]) : 200000;
+    constexpr std::size_t lookups = 200000;
+    // Both stores parse the document, neither uses a pre-parsed copy
+    benchmark::disableSettingsCache();
+    Poco::File("appdata").createDirectories();
+
+    auto path = std::string("appdata/bench_xml.xml");
+    std::vector<std::string> names;
+    {
+        auto writer = openWriter(path, Settings::Format::XML);
+        for (int i = 0; i < keys; ++i)
+        {
+            names.push_back("section" + std::to_string(i / 100) + ".key" + std::to_string(i % 100));
+            writer->write(names.back(), "a moderately long value number " + std::to_string(i));
+        }
+        writer->close();
+    }
+    std::cout << "bench_xml.xml: " << Poco::File(path).getSize() / 1024 << " KiB, " << keys << " keys\n";
+
+    // The flat store goes first, the memory released by the DOM is not always returned to the system
+    {
+        auto before = residentKiB();
+        Settings settings("bench_xml.xml", "appdata", false, Settings::Format::XML);
+        benchmark::measureOnce("flat store, load", [&settings]() { settings.load(); });
+        std::cout << "flat store, resident memory: " << residentKiB() - before << " KiB\n";
+        benchmark::measure("flat store, lookup", lookups, [&settings, &names](std::size_t i) {
+            benchmark::doNotOptimize(settings.getString(names[(i * 7919) % names.size()]));
+        });
+    }
+    {
+        auto before = residentKiB();
+        Poco::AutoPtr<Poco::Util::XMLConfiguration> dom(new Poco::Util::XMLConfiguration());
+        benchmark::measureOnce("DOM, load", [&dom, &path]() { dom->load(path); });
+        std::cout << "DOM, resident memory: " << residentKiB() - before << " KiB\n";
+        benchmark::measure("DOM, lookup", lookups, [&dom, &names](std::size_t i) {
+            benchmark::doNotOptimize(dom->getString(names[(i * 7919) % names.size()]));
+        });
+    }
+    return 0;
+}
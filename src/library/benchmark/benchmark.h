@@ -0,0 +1,82 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "settings.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace benchmark
+{
+
+/**
+ * Keeps the compiler from discarding a computed value
+ */
+template <typename T> void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Runs a function and prints its mean cost per iteration
+ * @param name label of the measurement
+ * @param iterations number of calls
+ * @param function callable that receives the iteration number
+ * @return the nanoseconds per iteration
+ */
+template <typename Function> double measure(const std::string& name, std::size_t iterations, Function&& function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        function(i);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    auto perIteration = elapsed.count() / static_cast<double>(iterations);
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed
+              << std::setprecision(1) << perIteration << " ns/op  (" << iterations << " iterations)\n";
+    return perIteration;
+}
+
+/**
+ * Runs a function once and prints its duration
+ * @param name label of the measurement
+ * @param function callable to time
+ * @return the elapsed milliseconds
+ */
+template <typename Function> double measureOnce(const std::string& name, Function&& function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed
+              << std::setprecision(2) << elapsed.count() << " ms\n";
+    return elapsed.count();
+}
+
+/**
+ * Turns the pre-parsed '<file>.cache' copies off, so every load of a changed file measures the parsing alone instead
+ * of the parsing plus the writing of the cache
+ */
+inline void disableSettingsCache()
+{
+#ifdef _WIN32
+    _putenv_s(SETTINGS_CACHE_ENVIRONMENT_VARIABLE, "0");
+#else
+    setenv(SETTINGS_CACHE_ENVIRONMENT_VARIABLE, "0", 1);
+#endif
+}
+
+} // namespace benchmark
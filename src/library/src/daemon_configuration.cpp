@@ -0,0 +1,242 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "daemon_configuration.h"
+#include "Poco/Environment.h"
+#include "Poco/Exception.h"
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/NetException.h"
+#include "Poco/Net/SocketAddress.h"
+#include "Poco/Net/StreamSocket.h"
+#include "Poco/NullStream.h"
+#include "Poco/NumberParser.h"
+#include "Poco/StreamCopier.h"
+#include "Poco/Timespan.h"
+#include "Poco/URI.h"
+#include "settings.h"
+#include "settings_stream_impl.h"
+#include <algorithm>
+#include <map>
+
+namespace project_library
+{
+
+namespace
+{
+
+Poco::Timespan requestTimeout()
+{
+    int milliseconds = DEFAULT_CONFIG_DAEMON_TIMEOUT;
+    if (!Poco::NumberParser::tryParse(Poco::Environment::get(CONFIG_DAEMON_TIMEOUT_ENVIRONMENT_VARIABLE, ""),
+                                      milliseconds) ||
+        milliseconds <= 0)
+    {
+        milliseconds = DEFAULT_CONFIG_DAEMON_TIMEOUT;
+    }
+    return Poco::Timespan(static_cast<Poco::Timespan::TimeDiff>(milliseconds) * 1000);
+}
+
+} // namespace
+
+DaemonConfiguration::DaemonConfiguration(std::string name, std::string address)
+    : m_name(std::move(name)), m_address(std::move(address))
+{
+}
+
+Poco::Net::HTTPClientSession& DaemonConfiguration::session()
+{
+    if (!m_session)
+    {
+        if (!m_address.empty() && m_address[0] == '/')
+        {
+#ifdef POCO_HAS_UNIX_SOCKET
+            Poco::Net::StreamSocket socket(Poco::Net::SocketAddress(Poco::Net::AddressFamily::UNIX_LOCAL, m_address));
+            m_session = std::make_unique<Poco::Net::HTTPClientSession>(socket);
+#else
+            throw ConnectionError("Unix sockets are not available on this platform: " + m_address);
+#endif
+        }
+        else
+        {
+            m_session = std::make_unique<Poco::Net::HTTPClientSession>(Poco::Net::SocketAddress(m_address));
+        }
+        m_session->setKeepAlive(true);
+        m_session->setTimeout(requestTimeout());
+    }
+    return *m_session;
+}
+
+void DaemonConfiguration::fetch()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string path;
+    Poco::URI::encode(m_name, "/?#", path);
+    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/settings/" + path,
+                                   Poco::Net::HTTPMessage::HTTP_1_1);
+    if (!m_etag.empty())
+    {
+        request.set("If-None-Match", m_etag);
+    }
+
+    std::map<std::string, std::string> values;
+    Poco::Net::HTTPResponse response;
+    try
+    {
+        session().sendRequest(request);
+        auto& body = session().receiveResponse(response);
+        if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK)
+        {
+            Poco::NullOutputStream discard;
+            Poco::StreamCopier::copyStream(body, discard);
+        }
+        else
+        {
+            createReader(body, Settings::Format::PropertyFile)
+                ->read([&values](const std::string& key, const std::string& value) { values[key] = value; });
+        }
+    }
+    catch (Poco::Net::NetException& e)
+    {
+        m_session.reset();
+        throw ConnectionError(e.displayText());
+    }
+    catch (Poco::IOException& e)
+    {
+        m_session.reset();
+        throw ConnectionError(e.displayText());
+    }
+    catch (Poco::TimeoutException& e)
+    {
+        // A daemon that stalls, the session may still receive its late answer and is not reused
+        m_session.reset();
+        throw ConnectionError(e.displayText());
+    }
+
+    switch (response.getStatus())
+    {
+    case Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED:
+        return;
+    case Poco::Net::HTTPResponse::HTTP_OK:
+        break;
+    case Poco::Net::HTTPResponse::HTTP_NOT_FOUND:
+        throw Poco::FileNotFoundException("settings document '" + m_name + "' on " + m_address);
+    default:
+        throw ConnectionError("Configuration daemon answered " + std::to_string(response.getStatus()) + " " +
+                              response.getReason());
+    }
+
+    Poco::Mutex::ScopedLock cacheLock(_mutex);
+    clear();
+    for (const auto& [key, value] : values)
+    {
+        MapConfiguration::setRaw(key, value);
+    }
+    // The changes not pushed yet are still the newest values
+    for (const auto& [key, value] : m_pending.changed)
+    {
+        MapConfiguration::setRaw(key, value);
+    }
+    for (const auto& key : m_pending.removed)
+    {
+        MapConfiguration::removeRaw(key);
+    }
+    m_etag = response.get("ETag", "");
+}
+
+void DaemonConfiguration::push()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SettingsPatch pending;
+    {
+        Poco::Mutex::ScopedLock cacheLock(_mutex);
+        std::swap(pending, m_pending);
+    }
+    if (pending.empty())
+    {
+        return;
+    }
+
+    std::string path;
+    Poco::URI::encode(m_name, "/?#", path);
+    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_PATCH, "/settings/" + path,
+                                   Poco::Net::HTTPMessage::HTTP_1_1);
+    auto body = pending.serialize();
+    request.setContentType("text/plain");
+    request.setContentLength(static_cast<std::streamsize>(body.size()));
+
+    Poco::Net::HTTPResponse response;
+    try
+    {
+        session().sendRequest(request) << body;
+        Poco::NullOutputStream discard;
+        Poco::StreamCopier::copyStream(session().receiveResponse(response), discard);
+    }
+    catch (Poco::Exception& e)
+    {
+        // Any failure of the request, a timeout included, keeps the changes for the next push
+        m_session.reset();
+        requeue(std::move(pending));
+        throw ConnectionError(e.displayText());
+    }
+    if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_NO_CONTENT &&
+        response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK)
+    {
+        requeue(std::move(pending));
+        throw ConnectionError("Configuration daemon answered " + std::to_string(response.getStatus()) + " " +
+                              response.getReason());
+    }
+    // When nobody else changed the document since our fetch, the cache already holds the new version. Otherwise the
+    // ETag is kept, so that the next fetch downloads the changes of the other clients.
+    Poco::Mutex::ScopedLock cacheLock(_mutex);
+    if (!m_etag.empty() && response.get("X-Previous-ETag", "") == m_etag)
+    {
+        m_etag = response.get("ETag", "");
+    }
+}
+
+std::string DaemonConfiguration::etag() const
+{
+    Poco::Mutex::ScopedLock cacheLock(_mutex);
+    return m_etag;
+}
+
+void DaemonConfiguration::requeue(SettingsPatch pending)
+{
+    Poco::Mutex::ScopedLock cacheLock(_mutex);
+    // The changes made while the request was in flight are newer than the ones it carried
+    for (const auto& key : m_pending.removed)
+    {
+        pending.changed.erase(key);
+        if (std::find(pending.removed.begin(), pending.removed.end(), key) == pending.removed.end())
+        {
+            pending.removed.push_back(key);
+        }
+    }
+    for (const auto& [key, value] : m_pending.changed)
+    {
+        pending.removed.erase(std::remove(pending.removed.begin(), pending.removed.end(), key), pending.removed.end());
+        pending.changed[key] = value;
+    }
+    m_pending = std::move(pending);
+}
+
+void DaemonConfiguration::setRaw(const std::string& key, const std::string& value)
+{
+    MapConfiguration::setRaw(key, value);
+    m_pending.changed[key] = value;
+    m_pending.removed.erase(std::remove(m_pending.removed.begin(), m_pending.removed.end(), key),
+                            m_pending.removed.end());
+}
+
+void DaemonConfiguration::removeRaw(const std::string& key)
+{
+    MapConfiguration::removeRaw(key);
+    m_pending.changed.erase(key);
+    m_pending.removed.push_back(key);
+}
+
+} // namespace project_library
@@ -0,0 +1,90 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/Net/HTTPClientSession.h"
+#include "Poco/Util/MapConfiguration.h"
+#include "settings_patch.h"
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace project_library
+{
+
+/**
+ * Client of the local configuration daemon. The values are cached in memory, fetch() downloads the whole document in
+ * a single request and sends the ETag of the cached copy, so an unchanged document costs an empty 304 response.
+ * The values are only available after the first fetch.
+ * The changes are kept in a pending patch and push() sends all of them in one request.
+ *
+ * Protocol, over HTTP/1.1 on a TCP or Unix socket:
+ *  - GET /settings/<name>, with If-None-Match, answers 200 with the document as a property file and its ETag,
+ *    304 if the document did not change or 404 if it does not exist
+ *  - PATCH /settings/<name>, with a serialized SettingsPatch as body, answers 204 with the new ETag and the ETag of the
+ *    version it patched in X-Previous-ETag. The client only adopts the new ETag when it patched the cached version.
+ */
+class DaemonConfiguration : public Poco::Util::MapConfiguration
+{
+  public:
+    /**
+     * Constructor, it does not connect until the first request
+     * @param name name of the settings document
+     * @param address 'host:port' or the path of a Unix socket
+     */
+    DaemonConfiguration(std::string name, std::string address);
+
+    /**
+     * Downloads the document if it changed since the last fetch, the pending changes are kept
+     * @throw Poco::FileNotFoundException if the daemon does not have the document
+     * @throw ConnectionError if the daemon can not be reached, fails or does not answer in time
+     */
+    void fetch();
+
+    /**
+     * Sends the pending changes, they are kept for the next push if the request fails
+     * @throw ConnectionError if the daemon can not be reached, fails or does not answer in time
+     */
+    void push();
+
+    /**
+     * @return the ETag of the cached document, empty before the first fetch
+     */
+    std::string etag() const;
+
+  protected:
+    void setRaw(const std::string& key, const std::string& value) override;
+    void removeRaw(const std::string& key) override;
+
+    ~DaemonConfiguration() override = default;
+
+  private:
+    /**
+     * Puts back the changes of a failed push, the changes made since then win
+     * @param pending changes sent by the failed request
+     */
+    void requeue(SettingsPatch pending);
+
+    /**
+     * @return the session, connected on first use and kept alive between requests. Its requests time out after the
+     * milliseconds of CONFIG_DAEMON_TIMEOUT_ENVIRONMENT_VARIABLE
+     */
+    Poco::Net::HTTPClientSession& session();
+
+    std::string m_name;
+    std::string m_address;
+    std::unique_ptr<Poco::Net::HTTPClientSession> m_session;
+    std::string m_etag;
+    SettingsPatch m_pending;
+
+    /**
+     * Serializes the requests, the cached values, the pending changes and the ETag are protected by the configuration
+     * mutex
+     */
+    std::mutex m_mutex;
+};
+
+} // namespace project_library
@@ -5,6 +5,7 @@
  */
 
 #include "exception.h"
+#include "settings_schema.h"
 
 namespace project_library
 {
@@ -18,4 +19,24 @@ char const* Exception::what() const noexcept
     return m_msg.c_str();
 }
 
+namespace
+{
+
+std::string describe(const std::vector<std::string>& violations)
+{
+    std::string message = "The settings do not match the schema:";
+    for (const auto& violation : violations)
+    {
+        message += "\n  " + violation;
+    }
+    return message;
+}
+
+} // namespace
+
+ValidationException::ValidationException(std::vector<std::string> violations)
+    : Exception(describe(violations)), m_violations(std::move(violations))
+{
+}
+
 } // namespace project_library
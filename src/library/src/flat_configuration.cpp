@@ -0,0 +1,304 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "flat_configuration.h"
+#include "settings_stream_impl.h"
+#include <algorithm>
+#include <set>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace project_library
+{
+
+namespace
+{
+
+/**
+ * Kinds of the parts of a key, in the order they are written in a document
+ */
+enum class Kind
+{
+    Attribute,
+    End,
+    Element,
+    Index
+};
+
+struct Part
+{
+    Kind kind;
+    std::string_view name;
+    unsigned long index;
+};
+
+/**
+ * Reads the next part of a key
+ * @param key
+ * @param pos position of the part, it is moved to the next one
+ * @return the part
+ */
+Part nextPart(const std::string& key, std::size_t& pos)
+{
+    if (pos < key.size() && key[pos] == '.')
+    {
+        ++pos;
+    }
+    if (pos >= key.size())
+    {
+        return {Kind::End, {}, 0};
+    }
+    if (key[pos] == '[')
+    {
+        auto close = std::min(key.find(']', pos), key.size());
+        auto start = pos + 1;
+        pos = close + 1;
+        if (start < close && key[start] == '@')
+        {
+            return {Kind::Attribute, std::string_view(key).substr(start + 1, close - start - 1), 0};
+        }
+        unsigned long index = 0;
+        for (auto i = start; i < close && key[i] >= '0' && key[i] <= '9'; ++i)
+        {
+            index = index * 10 + static_cast<unsigned long>(key[i] - '0');
+        }
+        return {Kind::Index, {}, index};
+    }
+    auto end = std::min(key.find_first_of(".[", pos), key.size());
+    Part part{Kind::Element, std::string_view(key).substr(pos, end - pos), 0};
+    pos = end;
+    return part;
+}
+
+} // namespace
+
+FlatConfiguration::FlatConfiguration(Settings::Format format) : m_format(format), m_root(defaultXmlRoot)
+{
+}
+
+void FlatConfiguration::load(std::istream& input)
+{
+    std::map<std::string, std::string> values;
+    std::set<std::string> literals;
+    std::string root = defaultXmlRoot;
+    createReader(input, m_format, &root)
+        ->readTyped([&values, &literals](const std::string& key, const std::string& value, bool literal) {
+            values.insert_or_assign(key, value);
+            if (literal)
+            {
+                literals.insert(key);
+            }
+            else
+            {
+                literals.erase(key);
+            }
+        });
+    Poco::Mutex::ScopedLock lock(_mutex);
+    m_values.swap(values);
+    m_literals.swap(literals);
+    m_root.swap(root);
+}
+
+void FlatConfiguration::save(std::ostream& output) const
+{
+    Poco::Mutex::ScopedLock lock(_mutex);
+    std::vector<const std::pair<const std::string, std::string>*> records;
+    records.reserve(m_values.size());
+    for (const auto& record : m_values)
+    {
+        records.push_back(&record);
+    }
+    std::sort(records.begin(), records.end(),
+              [](const auto* left, const auto* right) { return naturalLess(left->first, right->first); });
+
+    auto writer = createWriter(output, m_format, m_root);
+    for (const auto* record : records)
+    {
+        writer->writeTyped(record->first, record->second, m_literals.count(record->first) != 0);
+    }
+    writer->close();
+}
+
+void FlatConfiguration::replace(std::vector<TypedRecord> records)
+{
+    std::map<std::string, std::string> values;
+    std::set<std::string> literals;
+    for (auto& record : records)
+    {
+        if (record.literal)
+        {
+            literals.insert(record.key);
+        }
+        values.insert_or_assign(std::move(record.key), std::move(record.value));
+    }
+    records.clear();
+    Poco::Mutex::ScopedLock lock(_mutex);
+    m_values.swap(values);
+    m_literals.swap(literals);
+}
+
+void FlatConfiguration::setLiteral(const std::string& key, const std::string& value)
+{
+    auto normalized = normalize(key, m_format);
+    Poco::Mutex::ScopedLock lock(_mutex);
+    if (m_format == Settings::Format::JSON)
+    {
+        m_literals.insert(normalized);
+    }
+    m_values.insert_or_assign(std::move(normalized), value);
+}
+
+void FlatConfiguration::update(const std::string& key, const std::string& value)
+{
+    auto normalized = normalize(key, m_format);
+    Poco::Mutex::ScopedLock lock(_mutex);
+    m_values.insert_or_assign(std::move(normalized), value);
+}
+
+std::string FlatConfiguration::root() const
+{
+    Poco::Mutex::ScopedLock lock(_mutex);
+    return m_root;
+}
+
+void FlatConfiguration::setRoot(const std::string& root)
+{
+    Poco::Mutex::ScopedLock lock(_mutex);
+    m_root = root;
+}
+
+void FlatConfiguration::forEach(const SettingsReader::TypedCallback& callback) const
+{
+    Poco::Mutex::ScopedLock lock(_mutex);
+    for (const auto& [key, value] : m_values)
+    {
+        callback(key, value, m_literals.count(key) != 0);
+    }
+}
+
+bool FlatConfiguration::naturalLess(const std::string& left, const std::string& right)
+{
+    std::size_t leftPos = 0;
+    std::size_t rightPos = 0;
+    while (true)
+    {
+        auto leftPart = nextPart(left, leftPos);
+        auto rightPart = nextPart(right, rightPos);
+        if (leftPart.kind != rightPart.kind)
+        {
+            return leftPart.kind < rightPart.kind;
+        }
+        if (leftPart.kind == Kind::End)
+        {
+            return false;
+        }
+        if (leftPart.kind == Kind::Index)
+        {
+            if (leftPart.index != rightPart.index)
+            {
+                return leftPart.index < rightPart.index;
+            }
+        }
+        else if (leftPart.name != rightPart.name)
+        {
+            return leftPart.name < rightPart.name;
+        }
+    }
+}
+
+bool FlatConfiguration::getRaw(const std::string& key, std::string& value) const
+{
+    auto normalized = normalize(key, m_format);
+    auto it = m_values.find(normalized);
+    if (it != m_values.end())
+    {
+        value = it->second;
+        return true;
+    }
+    // An element that only holds children or attributes exists, without a value of its own
+    if (!normalized.empty() && (hasPrefix(normalized + '.') || hasPrefix(normalized + "[@")))
+    {
+        value.clear();
+        return true;
+    }
+    return false;
+}
+
+void FlatConfiguration::setRaw(const std::string& key, const std::string& value)
+{
+    auto normalized = normalize(key, m_format);
+    m_literals.erase(normalized);
+    m_values.insert_or_assign(std::move(normalized), value);
+}
+
+void FlatConfiguration::enumerate(const std::string& key, Keys& range) const
+{
+    auto prefix = key.empty() ? key : normalize(key, m_format) + '.';
+    std::unordered_set<std::string> seen;
+    for (auto it = m_values.lower_bound(prefix); it != m_values.end(); ++it)
+    {
+        if (it->first.compare(0, prefix.size(), prefix) != 0)
+        {
+            break;
+        }
+        auto name = it->first.substr(prefix.size(), it->first.find('.', prefix.size()) - prefix.size());
+        if (seen.insert(name).second)
+        {
+            range.push_back(std::move(name));
+        }
+    }
+}
+
+void FlatConfiguration::removeRaw(const std::string& key)
+{
+    auto normalized = normalize(key, m_format);
+    m_values.erase(normalized);
+    m_literals.erase(normalized);
+    for (const auto& prefix : {normalized + '.', normalized + "[@"})
+    {
+        auto it = m_values.lower_bound(prefix);
+        while (it != m_values.end() && it->first.compare(0, prefix.size(), prefix) == 0)
+        {
+            it = m_values.erase(it);
+        }
+        auto literal = m_literals.lower_bound(prefix);
+        while (literal != m_literals.end() && literal->compare(0, prefix.size(), prefix) == 0)
+        {
+            literal = m_literals.erase(literal);
+        }
+    }
+}
+
+std::string FlatConfiguration::normalize(const std::string& key, Settings::Format format)
+{
+    if (format != Settings::Format::XML || key.find("[0]") == std::string::npos)
+    {
+        return key;
+    }
+    std::string normalized;
+    normalized.reserve(key.size());
+    for (std::size_t pos = 0; pos < key.size();)
+    {
+        if (key.compare(pos, 3, "[0]") == 0)
+        {
+            pos += 3;
+        }
+        else
+        {
+            normalized += key[pos++];
+        }
+    }
+    return normalized;
+}
+
+bool FlatConfiguration::hasPrefix(const std::string& prefix) const
+{
+    auto it = m_values.lower_bound(prefix);
+    return it != m_values.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+}
+
+} // namespace project_library
@@ -0,0 +1,126 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/Util/AbstractConfiguration.h"
+#include "settings.h"
+#include "settings_stream_impl.h"
+#include <istream>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace project_library
+{
+
+/**
+ * Configuration that keeps the values of a document as a flat key/value map. The document is read in one pass by the
+ * streaming reader of its format and written back by the streaming writer, no document tree is kept in memory and a
+ * lookup is a single map search. The keys follow the mapping of the format, e.g. 'section.value1', 'list[1]' or
+ * 'element[@attribute]'.
+ */
+class FlatConfiguration : public Poco::Util::AbstractConfiguration
+{
+  public:
+    /**
+     * Constructor
+     * @param format format of the document
+     */
+    explicit FlatConfiguration(Settings::Format format);
+
+    /**
+     * Replaces the values with the content of a document, the name of the root element of an XML document is kept
+     * for save()
+     * @param input document
+     * @throw SyntaxException if the document is malformed
+     */
+    void load(std::istream& input);
+
+    /**
+     * Writes the values as a document, the keys are sorted in their natural order: attributes before the content of
+     * their element, the children of an element together and the indexes by their numeric value
+     * @param output destination
+     */
+    void save(std::ostream& output) const;
+
+    /**
+     * @return the name of the root element of the XML document, 'config' until a document is loaded
+     */
+    std::string root() const;
+
+    /**
+     * @param root name of the root element written by save()
+     */
+    void setRoot(const std::string& root);
+
+    /**
+     * Replaces the values with records, in a single step like load()
+     * @param records keys, raw values and their types
+     */
+    void replace(std::vector<TypedRecord> records);
+
+    /**
+     * Sets a value that a JSON document holds as a number or a boolean, the inherited setters store strings
+     * @param key
+     * @param value text of the number or the boolean
+     */
+    void setLiteral(const std::string& key, const std::string& value);
+
+    /**
+     * Sets a value and keeps its type, a new key holds a string
+     * @param key
+     * @param value
+     */
+    void update(const std::string& key, const std::string& value);
+
+    /**
+     * Visits every value in key order, under the lock of the configuration
+     * @param callback is called once for every key
+     */
+    void forEach(const SettingsReader::TypedCallback& callback) const;
+
+    /**
+     * @param left
+     * @param right
+     * @return true if the left key goes before the right key in a document
+     */
+    static bool naturalLess(const std::string& left, const std::string& right);
+
+    /**
+     * @param key
+     * @param format
+     * @return the key in the form stored by the flat stores, an XML key addresses the first element with or without
+     * '[0]'
+     */
+    static std::string normalize(const std::string& key, Settings::Format format);
+
+  protected:
+    bool getRaw(const std::string& key, std::string& value) const override;
+    void setRaw(const std::string& key, const std::string& value) override;
+    void enumerate(const std::string& key, Keys& range) const override;
+    void removeRaw(const std::string& key) override;
+
+    ~FlatConfiguration() override = default;
+
+  private:
+    /**
+     * @return true if any stored key starts with the prefix
+     */
+    bool hasPrefix(const std::string& prefix) const;
+
+    Settings::Format m_format;
+    std::string m_root;
+    std::map<std::string, std::string> m_values;
+
+    /**
+     * Keys of the values that a JSON document holds as numbers or booleans
+     */
+    std::set<std::string> m_literals;
+};
+
+} // namespace project_library
@@ -32,4 +32,9 @@ class FileNotFound : public Exception
     using Exception::Exception;
 };
 
+class ConnectionError : public Exception
+{
+    using Exception::Exception;
+};
+
 } // namespace project_library
@@ -7,8 +7,31 @@
 #pragma once
 #include "exception.h"
 #include "helpers.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 
+/**
+ * Address of the local configuration daemon used by Settings::Format::Daemon, either 'host:port' or the path of a
+ * Unix socket. It defaults to DEFAULT_CONFIG_DAEMON_ADDRESS.
+ */
+#define CONFIG_DAEMON_ENVIRONMENT_VARIABLE "PROJECT_LIBRARY_CONFIG_DAEMON"
+#define DEFAULT_CONFIG_DAEMON_ADDRESS "127.0.0.1:7077"
+
+/**
+ * Milliseconds that a request to the configuration daemon waits for it before failing with a ConnectionError. It
+ * defaults to DEFAULT_CONFIG_DAEMON_TIMEOUT.
+ */
+#define CONFIG_DAEMON_TIMEOUT_ENVIRONMENT_VARIABLE "PROJECT_LIBRARY_CONFIG_DAEMON_TIMEOUT"
+#define DEFAULT_CONFIG_DAEMON_TIMEOUT 60000
+
+/**
+ * The pre-parsed copies of the settings files, '<file>.cache', are neither read nor written while this environment
+ * variable is set to '0'.
+ */
+#define SETTINGS_CACHE_ENVIRONMENT_VARIABLE "PROJECT_LIBRARY_SETTINGS_CACHE"
+
 namespace project_library
 {
 
@@ -23,6 +46,8 @@ class SyntaxException : public Exception
 };
 
 class SettingsImpl;
+struct SettingsPatch;
+struct SettingsSchema;
 
 class Settings
 {
@@ -37,22 +62,56 @@ class Settings
         WinRegistry,
 #endif
         Filesystem,
+        /**
+         * JSON file, the numbers and the booleans of the loaded file and the values set by setInt(), setDouble() and
+         * setBool() are saved without quotes, every other value is saved as a string
+         */
         JSON,
         IniFile,
+        /**
+         * XML file, the root element is not part of the keys and it is saved with the name it was loaded with,
+         * 'config' for a new file. The comments and the processing instructions are dropped on load and they are not
+         * saved back.
+         */
         XML,
-        PropertyFile
+        PropertyFile,
+        /**
+         * Values served by the local configuration daemon, the filename is the name of the settings document on the
+         * daemon. The daemon address is read from the CONFIG_DAEMON_ENVIRONMENT_VARIABLE environment variable.
+         */
+        Daemon
+    };
+
+    /**
+     * How the values are kept in memory
+     */
+    enum class Store
+    {
+        /**
+         * The configuration of the format, every access takes its single lock
+         */
+        Document,
+        /**
+         * A flat store split in independently locked shards, for the values written from many threads at once. It is
+         * only available for the JSON, ini, XML and property files, the other formats use Document.
+         */
+        Sharded
     };
 
     /**
-     * Constructor
+     * Constructor, it does not access the filesystem: the path is resolved on first use and the folders are created
+     * by the first save(). The instances that point to the same file share the values parsed from it.
      *
      * @param filename filename that store the settings
      * @param pathSuffix is a suffix to add to the path
      * @param inConfigHome if false uses the current path, if true uses a config home folder, on Unix systems is the
      * '~/.config/', on Windows systems, this is '%APPDATA%' (typically C:\Users\user\AppData\Roaming).
+     * @param format format of the settings
+     * @param store how the values are kept in memory, the instances share the values only if they use the same store
      */
     LIBRARY_API explicit Settings(const std::string& filename, const std::string& pathSuffix = "",
-                                  const bool inConfigHome = true, Format format = Format::IniFile) noexcept;
+                                  const bool inConfigHome = true, Format format = Format::IniFile,
+                                  Store store = Store::Document) noexcept;
 
     /**
      * Destructor
@@ -138,16 +197,92 @@ class Settings
     LIBRARY_API bool exists(const std::string& key) const;
 
     /**
-     * Load the values from the config source
+     * Load the values from the config source, gzip compressed files are detected and decompressed transparently.
+     * The file is only parsed again if it changed on disk since it was loaded or saved by any instance, or if a value
+     * was set and not saved since then: the values set and not saved are discarded. A change is detected by the
+     * modification time and the size of the file, a rewrite that keeps the size within the timestamp resolution of the
+     * filesystem is not seen. The JSON, XML, ini and property files keep a pre-parsed copy next to them,
+     * '<file>.cache', that replaces the parsing while the file does not change, unless
+     * SETTINGS_CACHE_ENVIRONMENT_VARIABLE disables it.
+     * @throw ValidationException if a schema was set and the values do not match it
      */
     LIBRARY_API void load();
 
     /**
-     * Save the values to the config source
+     * Save the values to the config source, the file is gzip compressed if its name ends in '.gz' or if it was
+     * compressed when it was loaded. The file is replaced only once it is completely written
      */
     LIBRARY_API void save();
 
+    /**
+     * Creates a child view that shares the storage of these settings, it is cheap enough to be created per request.
+     * The values set in the child are kept in the child, every other key is read from these settings, including the
+     * changes made after the child was created. The child keeps the shared storage alive and it can not be loaded or
+     * saved.
+     * @return the child settings
+     */
+    LIBRARY_API std::unique_ptr<Settings> overlay() const;
+
+    /**
+     * Callback that receives a key and its value
+     */
+    using Visitor = std::function<void(const std::string& key, const std::string& value)>;
+
+    /**
+     * Visits every key that holds a value, the values are raw, references to other properties are not expanded
+     * @param callback is called once for every key
+     */
+    LIBRARY_API void forEach(const Visitor& callback) const;
+
+    /**
+     * Applies a patch in place, without reloading the config source. The changes are not saved. A changed value keeps
+     * its type, e.g. a JSON number stays a number, and an added value is a string
+     * @param patch changes created by diff()
+     */
+    LIBRARY_API void apply(const SettingsPatch& patch);
+
+    /**
+     * Sets the schema checked by every load(), the typed getters of the keys that pass the check return the value
+     * converted by the check instead of parsing it again
+     * @param schema expected values
+     */
+    LIBRARY_API void setSchema(const SettingsSchema& schema);
+
+    /**
+     * Counters of the pre-parsed copies used by load()
+     */
+    struct CacheStatistics
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+    };
+
+    /**
+     * @return the cache hits and misses of the process
+     */
+    LIBRARY_API static CacheStatistics cacheStatistics();
+
+    /**
+     * Starts recording the keys read by the getters, usually at the beginning of the startup
+     */
+    LIBRARY_API void recordAccessProfile();
+
+    /**
+     * Stops the recording and saves the keys read since recordAccessProfile() next to the settings, as
+     * '<file>.profile'. For the filesystem format, the next load() reads the files of those keys ahead on a
+     * background thread. The other formats hold every value in memory once loaded, they have nothing to warm.
+     * @throw NotImplemented if the settings are not stored in files
+     */
+    LIBRARY_API void saveAccessProfile();
+
+    /**
+     * @return the number of values warmed from the access profiles by the process
+     */
+    LIBRARY_API static std::uint64_t warmedValues();
+
   private:
+    explicit Settings(std::unique_ptr<SettingsImpl> impl) noexcept;
+
     PIMPL(SettingsImpl)
 };
 
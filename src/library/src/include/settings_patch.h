@@ -0,0 +1,83 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "helpers.h"
+#include "settings.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace project_library
+{
+
+/**
+ * Minimal set of changes that turns one configuration into another, it is applied with Settings::apply()
+ */
+struct SettingsPatch
+{
+    /**
+     * Keys that only exist in the new configuration, with their values
+     */
+    std::map<std::string, std::string> added;
+
+    /**
+     * Keys whose value is different in the new configuration, with their new values
+     */
+    std::map<std::string, std::string> changed;
+
+    /**
+     * Keys that only exist in the old configuration
+     */
+    std::vector<std::string> removed;
+
+    /**
+     * @return true if both configurations are equal
+     */
+    LIBRARY_API bool empty() const;
+
+    /**
+     * @return the number of changes
+     */
+    LIBRARY_API std::size_t size() const;
+
+    /**
+     * Serializes the patch in a compact text form, one change per line: '+key<TAB>value' for an added key,
+     * '~key<TAB>value' for a changed key and '-key' for a removed key. Tabs, line breaks and backslashes are escaped.
+     * @return the serialized patch
+     */
+    LIBRARY_API std::string serialize() const;
+
+    /**
+     * Parses a serialized patch
+     * @param data serialized patch
+     * @return the patch
+     * @throw SyntaxException if data is not a serialized patch
+     */
+    LIBRARY_API static SettingsPatch parse(const std::string& data);
+};
+
+/**
+ * Computes the changes between two loaded configurations, the raw values are compared
+ * @param from old configuration
+ * @param to new configuration
+ * @return the patch that turns from into to
+ */
+LIBRARY_API SettingsPatch diff(const Settings& from, const Settings& to);
+
+/**
+ * Computes the changes between two files without loading them in a Settings instance
+ * @param fromPath old configuration
+ * @param toPath new configuration
+ * @param format format of both files
+ * @return the patch that turns the first file into the second one
+ * @throw FileNotFound if a file does not exist
+ * @throw SyntaxException if a file is malformed
+ */
+LIBRARY_API SettingsPatch diff(const std::string& fromPath, const std::string& toPath, Settings::Format format);
+
+} // namespace project_library
@@ -0,0 +1,101 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "exception.h"
+#include "helpers.h"
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace project_library
+{
+
+/**
+ * Thrown by Settings::load() when the values do not match the schema
+ */
+class ValidationException : public Exception
+{
+  public:
+    /**
+     * Constructor
+     * @param violations one description per invalid key
+     */
+    LIBRARY_API explicit ValidationException(std::vector<std::string> violations);
+
+    /**
+     * @return every violation found by the validation, not only the first one
+     */
+    const std::vector<std::string>& violations() const noexcept
+    {
+        return m_violations;
+    }
+
+  private:
+    std::vector<std::string> m_violations;
+};
+
+/**
+ * Declarative description of the expected values, Settings::load() checks all of them in one pass. The values that
+ * pass the check are kept converted, so the typed getters of the declared keys do not parse them again.
+ */
+struct SettingsSchema
+{
+    enum class Type
+    {
+        String,
+        Int,
+        Double,
+        Bool
+    };
+
+    /**
+     * Constraints of one key
+     */
+    struct Rule
+    {
+        Type type = Type::String;
+
+        /**
+         * A missing required key is a violation, a missing optional key is not
+         */
+        bool required = false;
+
+        /**
+         * Inclusive range of the Int and Double values
+         */
+        std::optional<double> minimum;
+        std::optional<double> maximum;
+
+        /**
+         * Accepted values, empty if any value of the type is accepted
+         */
+        std::vector<std::string> allowed;
+    };
+
+    /**
+     * Rules by key, the keys use the same mapping as the Settings getters
+     */
+    std::map<std::string, Rule> rules;
+
+    /**
+     * Declares a key
+     * @param key
+     * @param type expected type of the value
+     * @param required if true the key must exist
+     * @return the rule, to add a range or the accepted values
+     */
+    Rule& define(const std::string& key, Type type, bool required = false)
+    {
+        auto& rule = rules[key];
+        rule.type = type;
+        rule.required = required;
+        return rule;
+    }
+};
+
+} // namespace project_library
@@ -0,0 +1,109 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "helpers.h"
+#include "settings.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace project_library
+{
+
+/**
+ * Reads the key/value records of a settings source one at a time, without building the whole document in memory.
+ * The keys use the same mapping as the Settings getters, e.g. 'section.value1', 'list[1]' or 'element[@attribute]'.
+ */
+class SettingsReader
+{
+  public:
+    using Callback = std::function<void(const std::string& key, const std::string& value)>;
+
+    /**
+     * Callback that also receives whether the value is a literal of the format, a JSON number or boolean, instead of
+     * a string
+     */
+    using TypedCallback = std::function<void(const std::string& key, const std::string& value, bool literal)>;
+
+    virtual ~SettingsReader() = default;
+
+    /**
+     * Reads every record of the source in document order
+     * @param callback is called once for every key that holds a value
+     * @throw SyntaxException if the source is malformed
+     */
+    virtual void read(const Callback& callback) = 0;
+
+    /**
+     * Reads every record of the source in document order with the type of its value, the formats without literals
+     * report every value as a string
+     * @param callback is called once for every key that holds a value
+     * @throw SyntaxException if the source is malformed
+     */
+    virtual void readTyped(const TypedCallback& callback)
+    {
+        read([&callback](const std::string& key, const std::string& value) { callback(key, value, false); });
+    }
+};
+
+/**
+ * Writes key/value records to a settings destination as they arrive. Records sharing a key prefix should be written
+ * consecutively, so that the writer can close each section as soon as the prefix changes.
+ */
+class SettingsWriter
+{
+  public:
+    virtual ~SettingsWriter() = default;
+
+    /**
+     * Writes a record
+     * @param key
+     * @param value
+     */
+    virtual void write(const std::string& key, const std::string& value) = 0;
+
+    /**
+     * Writes a record with the type of its value. write() guesses the type instead: a JSON writer writes the values
+     * that read as numbers or booleans without quotes
+     * @param key
+     * @param value
+     * @param literal true to write the value as a literal of the format, a JSON number or boolean, false to write it
+     * as a string. The formats without literals ignore it
+     */
+    virtual void writeTyped(const std::string& key, const std::string& value, bool literal)
+    {
+        (void)literal;
+        write(key, value);
+    }
+
+    /**
+     * Completes the document and flushes the destination, no more records can be written after this call. The records
+     * are written in large blocks, the destination may not hold all of them before this call
+     */
+    virtual void close() = 0;
+};
+
+/**
+ * Opens a streaming reader
+ * @param path file to read, for Format::Filesystem the root folder of the settings
+ * @param format format of the source
+ * @return the reader
+ * @throw FileNotFound if the source does not exist
+ * @throw NotImplemented if the format can not be streamed
+ */
+LIBRARY_API std::unique_ptr<SettingsReader> openReader(const std::string& path, Settings::Format format);
+
+/**
+ * Opens a streaming writer, an existing destination is overwritten
+ * @param path file to write, for Format::Filesystem the root folder of the settings
+ * @param format format of the destination
+ * @return the writer
+ * @throw NotImplemented if the format can not be written
+ */
+LIBRARY_API std::unique_ptr<SettingsWriter> openWriter(const std::string& path, Settings::Format format);
+
+} // namespace project_library
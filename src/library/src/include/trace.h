@@ -0,0 +1,70 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "helpers.h"
+#include <cstdint>
+
+/**
+ * Tracing is enabled when this environment variable holds the name of the output file, the events are written in the
+ * Chrome trace-event JSON format that chrome://tracing and https://ui.perfetto.dev open.
+ */
+#define TRACE_ENVIRONMENT_VARIABLE "PROJECT_LIBRARY_TRACE"
+
+namespace project_library
+{
+
+/**
+ * Records the time spent in a scope as a complete trace event. It costs a single check when tracing is disabled.
+ * The name and the category must be string literals, only their address is stored.
+ */
+class TraceSpan
+{
+    DISABLE_COPY_AND_MOVE(TraceSpan)
+  public:
+    /**
+     * Constructor, starts the span
+     * @param name name of the event
+     * @param category category of the event
+     */
+    LIBRARY_API explicit TraceSpan(const char* name, const char* category = "settings") noexcept;
+
+    /**
+     * Destructor, ends the span
+     */
+    LIBRARY_API ~TraceSpan();
+
+  private:
+    const char* m_name;
+    const char* m_category;
+    std::int64_t m_start;
+};
+
+/**
+ * @return true if the trace events are being recorded
+ */
+LIBRARY_API bool traceEnabled() noexcept;
+
+/**
+ * Records an instant event
+ * @param name name of the event, a string literal
+ * @param category category of the event, a string literal
+ */
+LIBRARY_API void traceInstant(const char* name, const char* category = "settings") noexcept;
+
+/**
+ * Names the calling thread in the trace
+ * @param name
+ */
+LIBRARY_API void traceThreadName(const char* name) noexcept;
+
+/**
+ * Writes the pending events to the trace file and completes it, it is called automatically when the process exits.
+ * The events are also written in batches while they are recorded, so the memory used by tracing stays bounded.
+ */
+LIBRARY_API void traceFlush();
+
+} // namespace project_library
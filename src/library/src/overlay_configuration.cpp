@@ -0,0 +1,83 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "overlay_configuration.h"
+#include <algorithm>
+
+namespace project_library
+{
+
+namespace
+{
+
+/**
+ * Reaches the protected members of another configuration, the way Poco::Util::LayeredConfiguration does as a friend
+ */
+class ParentAccess : public Poco::Util::AbstractConfiguration
+{
+  public:
+    /**
+     * Looks a key up once, under the lock of the configuration
+     * @param config
+     * @param key
+     * @param value
+     * @return true if the key exists
+     */
+    static bool readRaw(const Poco::Util::AbstractConfiguration& config, const std::string& key, std::string& value)
+    {
+        Poco::Mutex::ScopedLock lock(const_cast<Poco::Mutex&>(config.*(&ParentAccess::_mutex)));
+        return (config.*(&ParentAccess::getRaw))(key, value);
+    }
+};
+
+} // namespace
+
+OverlayConfiguration::OverlayConfiguration(Poco::AutoPtr<Poco::Util::AbstractConfiguration> parent)
+    : m_parent(std::move(parent))
+{
+}
+
+bool OverlayConfiguration::getRaw(const std::string& key, std::string& value) const
+{
+    auto it = m_overrides.find(key);
+    if (it != m_overrides.end())
+    {
+        value = it->second;
+        return true;
+    }
+    return ParentAccess::readRaw(*m_parent, key, value);
+}
+
+void OverlayConfiguration::setRaw(const std::string& key, const std::string& value)
+{
+    m_overrides[key] = value;
+}
+
+void OverlayConfiguration::enumerate(const std::string& key, Keys& range) const
+{
+    m_parent->keys(key, range);
+
+    auto prefix = key.empty() ? key : key + '.';
+    for (auto it = m_overrides.lower_bound(prefix); it != m_overrides.end(); ++it)
+    {
+        if (it->first.compare(0, prefix.size(), prefix) != 0)
+        {
+            break;
+        }
+        auto name = it->first.substr(prefix.size(), it->first.find('.', prefix.size()) - prefix.size());
+        if (std::find(range.begin(), range.end(), name) == range.end())
+        {
+            range.push_back(name);
+        }
+    }
+}
+
+void OverlayConfiguration::removeRaw(const std::string& key)
+{
+    m_overrides.erase(key);
+}
+
+} // namespace project_library
@@ -0,0 +1,42 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/AutoPtr.h"
+#include "Poco/Util/AbstractConfiguration.h"
+#include <map>
+#include <string>
+
+namespace project_library
+{
+
+/**
+ * Copy-on-write view of another configuration. The parent is shared, only the keys set through the overlay are
+ * stored locally and every other read falls through to the parent.
+ */
+class OverlayConfiguration : public Poco::Util::AbstractConfiguration
+{
+  public:
+    /**
+     * Constructor
+     * @param parent configuration that answers the keys not overridden
+     */
+    explicit OverlayConfiguration(Poco::AutoPtr<Poco::Util::AbstractConfiguration> parent);
+
+  protected:
+    bool getRaw(const std::string& key, std::string& value) const override;
+    void setRaw(const std::string& key, const std::string& value) override;
+    void enumerate(const std::string& key, Keys& range) const override;
+    void removeRaw(const std::string& key) override;
+
+    ~OverlayConfiguration() override = default;
+
+  private:
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> m_parent;
+    std::map<std::string, std::string> m_overrides;
+};
+
+} // namespace project_library
@@ -5,14 +5,21 @@
  */
 
 #include "settings.h"
+#include "settings_cache.h"
 #include "settings_impl.h"
+#include "settings_patch.h"
+#include "settings_schema.h"
 
 namespace project_library
 {
 
 Settings::Settings(const std::string& filename, const std::string& pathSuffix, const bool inConfigHome,
-                   Settings::Format format) noexcept
-    : m_pImpl(new SettingsImpl(filename, pathSuffix, inConfigHome, format))
+                   Settings::Format format, Settings::Store store) noexcept
+    : m_pImpl(new SettingsImpl(filename, pathSuffix, inConfigHome, format, store))
+{
+}
+
+Settings::Settings(std::unique_ptr<SettingsImpl> impl) noexcept : m_pImpl(std::move(impl))
 {
 }
 
@@ -73,4 +80,44 @@ void Settings::save()
     m_pImpl->save();
 }
 
+std::unique_ptr<Settings> Settings::overlay() const
+{
+    return std::unique_ptr<Settings>(new Settings(m_pImpl->overlay()));
+}
+
+void Settings::forEach(const Settings::Visitor& callback) const
+{
+    m_pImpl->forEach(callback);
+}
+
+void Settings::apply(const SettingsPatch& patch)
+{
+    m_pImpl->apply(patch);
+}
+
+void Settings::setSchema(const SettingsSchema& schema)
+{
+    m_pImpl->setSchema(schema);
+}
+
+Settings::CacheStatistics Settings::cacheStatistics()
+{
+    return SettingsCache::statistics();
+}
+
+std::uint64_t Settings::warmedValues()
+{
+    return SettingsImpl::warmed();
+}
+
+void Settings::recordAccessProfile()
+{
+    m_pImpl->recordAccessProfile();
+}
+
+void Settings::saveAccessProfile()
+{
+    m_pImpl->saveAccessProfile();
+}
+
 } // namespace project_library
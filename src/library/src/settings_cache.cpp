@@ -0,0 +1,271 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "settings_cache.h"
+#include "trace.h"
+#include "Poco/Environment.h"
+#include "Poco/Exception.h"
+#include "Poco/FileStream.h"
+#include "Poco/Path.h"
+#include "Poco/SharedMemory.h"
+#include "Poco/TemporaryFile.h"
+#include <atomic>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace project_library
+{
+
+namespace
+{
+
+constexpr char cacheSuffix[] = ".cache";
+constexpr std::uint32_t cacheMagic = 0x43534c50; // "PLSC"
+constexpr std::uint32_t cacheVersion = 3;
+constexpr std::uint64_t hashBasis = 0xcbf29ce484222325ULL;
+constexpr std::uint64_t hashPrime = 0x100000001b3ULL;
+constexpr std::size_t hashChunk = 64 * 1024;
+
+struct Header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::int64_t modified;
+    std::uint64_t size;
+    std::uint64_t hash;
+    std::uint64_t records;
+    std::uint64_t rootLength;
+};
+
+std::atomic<std::uint64_t> cacheHits{0};
+std::atomic<std::uint64_t> cacheMisses{0};
+
+template <typename T> bool take(const char*& cursor, const char* end, T& value)
+{
+    if (static_cast<std::size_t>(end - cursor) < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+template <typename T> void put(std::string& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * Removes what a failed store left behind
+ * @param temporary path of the temporary file, empty if it was not named yet
+ */
+void removeTemporary(const std::string& temporary)
+{
+    try
+    {
+        Poco::File file(temporary);
+        if (!temporary.empty() && file.exists())
+        {
+            file.remove();
+        }
+    }
+    catch (Poco::Exception&)
+    {
+    }
+}
+
+} // namespace
+
+bool SettingsCache::enabled()
+{
+    return Poco::Environment::get(SETTINGS_CACHE_ENVIRONMENT_VARIABLE, "") != "0";
+}
+
+Settings::CacheStatistics SettingsCache::statistics()
+{
+    return {cacheHits.load(), cacheMisses.load()};
+}
+
+SettingsCache::SettingsCache(const std::string& sourcePath) : m_path(sourcePath + cacheSuffix)
+{
+}
+
+std::uint64_t SettingsCache::hash(std::istream& content)
+{
+    HashingInputStream input(content);
+    return input.hash();
+}
+
+bool SettingsCache::restore(const Poco::Timestamp& modified, Poco::File::FileSize size,
+                            const std::function<std::uint64_t()>& hash, std::string& root,
+                            const SettingsReader::TypedCallback& callback) const
+{
+    try
+    {
+        Poco::File file(m_path);
+        if (!file.exists() || file.getSize() < sizeof(Header))
+        {
+            ++cacheMisses;
+            return false;
+        }
+        Poco::SharedMemory memory(file, Poco::SharedMemory::AM_READ);
+        const char* cursor = memory.begin();
+        const char* end = memory.end();
+
+        Header header{};
+        take(cursor, end, header);
+        if (header.magic != cacheMagic || header.version != cacheVersion ||
+            header.modified != modified.epochMicroseconds() || header.size != size || header.hash != hash())
+        {
+            ++cacheMisses;
+            return false;
+        }
+        if (static_cast<std::size_t>(end - cursor) < header.rootLength)
+        {
+            ++cacheMisses;
+            return false;
+        }
+        std::string_view mappedRoot(cursor, header.rootLength);
+        cursor += header.rootLength;
+
+        // The whole cache is checked before the first record is replayed, a damaged cache is a plain miss
+        struct MappedRecord
+        {
+            std::string_view key;
+            std::string_view value;
+            bool literal;
+        };
+        // Smallest record: the two lengths and the literal flag, a count that can not fit in the rest is damage
+        constexpr std::size_t minimumRecord = 2 * sizeof(std::uint32_t) + sizeof(std::uint8_t);
+        if (header.records > static_cast<std::size_t>(end - cursor) / minimumRecord)
+        {
+            ++cacheMisses;
+            return false;
+        }
+        std::vector<MappedRecord> records;
+        records.reserve(static_cast<std::size_t>(header.records));
+        for (std::uint64_t i = 0; i < header.records; ++i)
+        {
+            std::uint32_t keyLength = 0;
+            std::uint32_t valueLength = 0;
+            std::uint8_t literal = 0;
+            if (!take(cursor, end, keyLength) || !take(cursor, end, valueLength) || !take(cursor, end, literal) ||
+                static_cast<std::size_t>(end - cursor) < std::size_t(keyLength) + valueLength)
+            {
+                ++cacheMisses;
+                return false;
+            }
+            records.push_back({std::string_view(cursor, keyLength), std::string_view(cursor + keyLength, valueLength),
+                               literal != 0});
+            cursor += keyLength + valueLength;
+        }
+
+        root.assign(mappedRoot);
+        std::string key;
+        std::string value;
+        for (const auto& record : records)
+        {
+            key.assign(record.key);
+            value.assign(record.value);
+            callback(key, value, record.literal);
+        }
+        ++cacheHits;
+        return true;
+    }
+    catch (Poco::Exception&)
+    {
+        ++cacheMisses;
+        return false;
+    }
+}
+
+void SettingsCache::store(const Poco::Timestamp& modified, Poco::File::FileSize size, std::uint64_t hash,
+                          const std::string& root, const Records& records) const
+{
+    std::string temporary;
+    try
+    {
+        std::string buffer;
+        std::uint64_t count = 0;
+        records([&buffer, &count](const std::string& key, const std::string& value, bool literal) {
+            put(buffer, static_cast<std::uint32_t>(key.size()));
+            put(buffer, static_cast<std::uint32_t>(value.size()));
+            put(buffer, static_cast<std::uint8_t>(literal ? 1 : 0));
+            buffer += key;
+            buffer += value;
+            ++count;
+        });
+
+        Header header{cacheMagic, cacheVersion, modified.epochMicroseconds(), size, hash, count, root.size()};
+        // A name of its own in the same folder, concurrent writers do not share it and the rename does not copy
+        temporary = Poco::TemporaryFile::tempName(Poco::Path(m_path).parent().toString());
+        {
+            Poco::FileOutputStream output(temporary, std::ios::out | std::ios::trunc | std::ios::binary);
+            output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            output.write(root.data(), static_cast<std::streamsize>(root.size()));
+            output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            output.close();
+        }
+        // Another process may be mapping the previous cache, the new one replaces it in a single step
+        Poco::File(temporary).renameTo(m_path);
+    }
+    catch (Poco::Exception&)
+    {
+        removeTemporary(temporary);
+    }
+}
+
+HashingInputStream::HashingInputStream(std::istream& source) : std::istream(nullptr), m_buffer(source.rdbuf())
+{
+    rdbuf(&m_buffer);
+}
+
+std::uint64_t HashingInputStream::hash()
+{
+    return m_buffer.hash();
+}
+
+HashingInputStream::Buffer::Buffer(std::streambuf* source) : m_source(source), m_hash(hashBasis), m_chunk(hashChunk)
+{
+}
+
+std::uint64_t HashingInputStream::Buffer::hash()
+{
+    while (underflow() != traits_type::eof())
+    {
+        setg(eback(), egptr(), egptr());
+    }
+    return m_hash;
+}
+
+HashingInputStream::Buffer::int_type HashingInputStream::Buffer::underflow()
+{
+    if (gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr());
+    }
+    std::streamsize read = 0;
+    {
+        // The file I/O and the decompression of every chunk, nested in the span that consumes the stream
+        TraceSpan span("read");
+        read = m_source->sgetn(m_chunk.data(), static_cast<std::streamsize>(m_chunk.size()));
+    }
+    if (read <= 0)
+    {
+        return traits_type::eof();
+    }
+    for (std::streamsize i = 0; i < read; ++i)
+    {
+        m_hash ^= static_cast<unsigned char>(m_chunk[i]);
+        m_hash *= hashPrime;
+    }
+    setg(m_chunk.data(), m_chunk.data(), m_chunk.data() + read);
+    return traits_type::to_int_type(*gptr());
+}
+
+} // namespace project_library
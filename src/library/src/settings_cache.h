@@ -0,0 +1,127 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/File.h"
+#include "Poco/Timestamp.h"
+#include "settings.h"
+#include "settings_stream.h"
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace project_library
+{
+
+/**
+ * Pre-parsed copy of a settings file, stored next to it as '<file>.cache'. It holds the key/value records of the file
+ * in a binary form that is mapped and replayed without any text parsing. The cache is only used while the source
+ * keeps the modification time, the size and the content hash it had when the cache was written.
+ *
+ * Layout, in native byte order: a Header, the name of the root element of an XML source and the records, each one as
+ * the key length and the value length (32 bits each), a byte that is 1 for a JSON number or boolean, and the bytes of
+ * the key and of the value.
+ */
+class SettingsCache
+{
+  public:
+    /**
+     * Constructor, it does not access the filesystem
+     * @param sourcePath settings file
+     */
+    explicit SettingsCache(const std::string& sourcePath);
+
+    /**
+     * Enumerates the records to store, calling back once per record
+     */
+    using Records = std::function<void(const SettingsReader::TypedCallback& callback)>;
+
+    /**
+     * @param content content of the settings file, it is read to the end in fixed size chunks
+     * @return FNV-1a hash of the content
+     */
+    static std::uint64_t hash(std::istream& content);
+
+    /**
+     * @return false if SETTINGS_CACHE_ENVIRONMENT_VARIABLE disables the caches
+     */
+    static bool enabled();
+
+    /**
+     * @return the hits and misses of the process
+     */
+    static Settings::CacheStatistics statistics();
+
+    /**
+     * Replays the records of the cache if it matches the source
+     * @param modified modification time of the source
+     * @param size size of the source
+     * @param hash returns the hash of the source content, it is only called if the modification time and the size
+     * match
+     * @param root receives the name of the root element of an XML source, empty for the other formats
+     * @param callback receives every record, it is not called at all if the cache is missing, stale or damaged
+     * @return true on a cache hit
+     */
+    bool restore(const Poco::Timestamp& modified, Poco::File::FileSize size, const std::function<std::uint64_t()>& hash,
+                 std::string& root, const SettingsReader::TypedCallback& callback) const;
+
+    /**
+     * Writes the cache of a source, the errors are ignored: without a cache the next load parses the source again
+     * @param modified modification time of the source
+     * @param size size of the source
+     * @param hash hash of the source content
+     * @param root name of the root element of an XML source, empty for the other formats
+     * @param records the records parsed from the source
+     */
+    void store(const Poco::Timestamp& modified, Poco::File::FileSize size, std::uint64_t hash, const std::string& root,
+               const Records& records) const;
+
+  private:
+    std::string m_path;
+};
+
+/**
+ * Input stream that computes the SettingsCache::hash of everything read through it, so a source is hashed while it
+ * is parsed instead of being read twice. Every chunk taken from the source is traced as a 'read' span
+ */
+class HashingInputStream : public std::istream
+{
+  public:
+    /**
+     * Constructor
+     * @param source stream that is read, it must outlive this stream
+     */
+    explicit HashingInputStream(std::istream& source);
+
+    /**
+     * Reads the rest of the source
+     * @return the hash of the whole content of the source
+     */
+    std::uint64_t hash();
+
+  private:
+    class Buffer : public std::streambuf
+    {
+      public:
+        explicit Buffer(std::streambuf* source);
+        std::uint64_t hash();
+
+      protected:
+        int_type underflow() override;
+
+      private:
+        std::streambuf* m_source;
+        std::uint64_t m_hash;
+        std::vector<char> m_chunk;
+    };
+
+    Buffer m_buffer;
+};
+
+} // namespace project_library
@@ -0,0 +1,102 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "settings_file.h"
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace project_library
+{
+
+namespace
+{
+
+// Gzip magic number, its first byte is a control character that no text settings file starts with
+constexpr unsigned char gzipMagic[] = {0x1f, 0x8b};
+
+} // namespace
+
+SettingsInputFile::SettingsInputFile(const std::string& path) : m_file(path, std::ios::in | std::ios::binary)
+{
+    char magic[sizeof(gzipMagic)] = {};
+    m_file.read(magic, sizeof(magic));
+    auto gzip = m_file.gcount() == static_cast<std::streamsize>(sizeof(magic)) &&
+                static_cast<unsigned char>(magic[0]) == gzipMagic[0] &&
+                static_cast<unsigned char>(magic[1]) == gzipMagic[1];
+    // Back to the first byte, a file shorter than the magic number leaves the stream failed
+    m_file.clear();
+    m_file.seekg(0);
+    if (gzip)
+    {
+        m_inflater = std::make_unique<Poco::InflatingInputStream>(m_file, Poco::InflatingStreamBuf::STREAM_GZIP);
+    }
+}
+
+std::istream& SettingsInputFile::stream()
+{
+    if (m_inflater)
+    {
+        return *m_inflater;
+    }
+    return m_file;
+}
+
+bool SettingsInputFile::compressed() const
+{
+    return m_inflater != nullptr;
+}
+
+SettingsOutputFile::SettingsOutputFile(const std::string& path, bool compress)
+    : m_file(path, std::ios::out | std::ios::trunc | std::ios::binary)
+{
+    if (compress)
+    {
+        m_deflater = std::make_unique<Poco::DeflatingOutputStream>(m_file, Poco::DeflatingStreamBuf::STREAM_GZIP);
+    }
+}
+
+std::ostream& SettingsOutputFile::stream()
+{
+    if (m_deflater)
+    {
+        return *m_deflater;
+    }
+    return m_file;
+}
+
+void SettingsOutputFile::close()
+{
+    if (m_deflater)
+    {
+        m_deflater->close();
+    }
+    m_file.close();
+}
+
+bool SettingsOutputFile::hasCompressedSuffix(const std::string& path)
+{
+    static const std::string suffix = ".gz";
+    return path.size() > suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void prefetchFile(const std::string& path)
+{
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
+
+} // namespace project_library
@@ -0,0 +1,89 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/DeflatingStream.h"
+#include "Poco/FileStream.h"
+#include "Poco/InflatingStream.h"
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace project_library
+{
+
+/**
+ * Settings file opened for reading. Gzip compressed files are detected by their magic bytes and decompressed while
+ * they are read, so the parsers never see the compressed data nor the whole decompressed file.
+ */
+class SettingsInputFile
+{
+  public:
+    /**
+     * Constructor
+     * @param path file to open
+     * @throw Poco::FileNotFoundException if the file does not exist
+     */
+    explicit SettingsInputFile(const std::string& path);
+
+    /**
+     * @return the decompressed content of the file
+     */
+    std::istream& stream();
+
+    /**
+     * @return true if the file is gzip compressed
+     */
+    bool compressed() const;
+
+  private:
+    Poco::FileInputStream m_file;
+    std::unique_ptr<Poco::InflatingInputStream> m_inflater;
+};
+
+/**
+ * Settings file opened for writing, optionally gzip compressed while it is written.
+ */
+class SettingsOutputFile
+{
+  public:
+    /**
+     * Constructor, an existing file is overwritten
+     * @param path file to create
+     * @param compress if true the content is gzip compressed
+     */
+    SettingsOutputFile(const std::string& path, bool compress);
+
+    /**
+     * @return the stream that receives the uncompressed content
+     */
+    std::ostream& stream();
+
+    /**
+     * Flushes the pending compressed data and closes the file
+     */
+    void close();
+
+    /**
+     * @param path
+     * @return true if the path has the '.gz' suffix of the files that must be saved compressed
+     */
+    static bool hasCompressedSuffix(const std::string& path);
+
+  private:
+    Poco::FileOutputStream m_file;
+    std::unique_ptr<Poco::DeflatingOutputStream> m_deflater;
+};
+
+/**
+ * Asks the system to read a file ahead into the page cache, the call returns before the data is read. It does nothing
+ * if the file does not exist or the platform does not support it.
+ * @param path
+ */
+void prefetchFile(const std::string& path);
+
+} // namespace project_library
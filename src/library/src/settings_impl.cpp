@@ -5,14 +5,29 @@
  */
 
 #include "settings_impl.h"
+#include "daemon_configuration.h"
+#include "flat_configuration.h"
+#include "overlay_configuration.h"
+#include "settings_cache.h"
+#include "settings_file.h"
+#include "settings_patch.h"
+#include "sharded_configuration.h"
+#include "trace.h"
+#include "Poco/Environment.h"
 #include "Poco/Exception.h"
 #include "Poco/File.h"
 #include "Poco/FileStream.h"
+#include "Poco/NumberFormatter.h"
+#include "Poco/NumberParser.h"
+#include "Poco/String.h"
+#include "Poco/TemporaryFile.h"
 #include "Poco/Util/FilesystemConfiguration.h"
 #include "Poco/Util/IniFileConfiguration.h"
-#include "Poco/Util/JSONConfiguration.h"
-#include "Poco/Util/PropertyFileConfiguration.h"
-#include "Poco/Util/XMLConfiguration.h"
+#include <algorithm>
+#include <charconv>
+#include <shared_mutex>
+#include <sstream>
+#include <variant>
 #ifdef _WIN32
 #include "Poco/Util/WinRegistryConfiguration.h"
 #endif
@@ -35,8 +50,14 @@ namespace project_library
 {
 
 Poco::AutoPtr<Poco::Util::AbstractConfiguration> factory(const Poco::Path& rootFolder, const std::string& filename,
-                                                         Settings::Format format)
+                                                         Settings::Format format, Settings::Store store,
+                                                         const std::string& daemonAddress)
 {
+    TraceSpan span("factory");
+    if (store == Settings::Store::Sharded)
+    {
+        return Poco::AutoPtr<Poco::Util::AbstractConfiguration>(new ShardedConfiguration(format));
+    }
     Poco::Util::AbstractConfiguration* ptr;
     switch (format)
     {
@@ -45,17 +66,16 @@ Poco::AutoPtr<Poco::Util::AbstractConfiguration> factory(const Poco::Path& rootF
         ptr = new Poco::Util::FilesystemConfiguration(filePath.toString());
         break;
     }
-    case Settings::Format::JSON:
-        ptr = new Poco::Util::JSONConfiguration();
-        break;
     case Settings::Format::IniFile:
         ptr = new Poco::Util::IniFileConfiguration();
         break;
+    case Settings::Format::JSON:
     case Settings::Format::XML:
-        ptr = new Poco::Util::XMLConfiguration();
-        break;
     case Settings::Format::PropertyFile:
-        ptr = new Poco::Util::PropertyFileConfiguration();
+        ptr = new FlatConfiguration(format);
+        break;
+    case Settings::Format::Daemon:
+        ptr = new DaemonConfiguration(filename, daemonAddress);
         break;
 #ifdef _WIN32
     case Settings::Format::WinRegistry:
@@ -68,57 +88,576 @@ Poco::AutoPtr<Poco::Util::AbstractConfiguration> factory(const Poco::Path& rootF
 }
 
 SettingsImpl::SettingsImpl(const std::string& filename, const std::string& pathSuffix, const bool inConfigHome,
-                           Settings::Format format) noexcept
-    : m_filename(filename), m_format(format), m_suffix(pathSuffix),
-      m_rootFolder(inConfigHome ? Poco::Path::configHome() : Poco::Path::current(), m_suffix)
+                           Settings::Format format, Settings::Store store) noexcept
+    : m_filename(filename), m_suffix(pathSuffix), m_inConfigHome(inConfigHome), m_format(format), m_store(store)
 {
-    m_config = factory(m_rootFolder, filename, format);
-    createFolders();
+    bool streamable = format == Settings::Format::JSON || format == Settings::Format::IniFile ||
+                      format == Settings::Format::XML || format == Settings::Format::PropertyFile;
+    if (!streamable)
+    {
+        m_store = Settings::Store::Document;
+    }
+}
+
+SettingsImpl::SettingsImpl(Poco::AutoPtr<Poco::Util::AbstractConfiguration> config, Settings::Format format) noexcept
+    : m_config(std::move(config)), m_format(format), m_overlay(true)
+{
+}
+
+SettingsImpl::~SettingsImpl()
+{
+    if (m_prefetch.joinable())
+    {
+        m_prefetch.join();
+    }
+}
+
+const Poco::Path& SettingsImpl::rootFolder() const
+{
+    std::call_once(m_rootFolderOnce, [this]() {
+        TraceSpan span("resolve path");
+        m_rootFolder = Poco::Path(m_inConfigHome ? Poco::Path::configHome() : Poco::Path::current(), m_suffix);
+    });
+    return m_rootFolder;
+}
+
+const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& SettingsImpl::config() const
+{
+    std::call_once(m_configOnce, [this]() {
+        if (!m_config.isNull())
+        {
+            return;
+        }
+        // The registry and the daemon name their documents, the files are keyed by their full path
+        std::string key = m_filename;
+        std::string daemonAddress;
+        if (m_format == Settings::Format::Daemon)
+        {
+            // Two daemons may serve documents with the same name
+            daemonAddress = Poco::Environment::get(CONFIG_DAEMON_ENVIRONMENT_VARIABLE, DEFAULT_CONFIG_DAEMON_ADDRESS);
+            key += '@' + daemonAddress;
+        }
+        bool named = m_format == Settings::Format::Daemon;
+#ifdef _WIN32
+        named = named || m_format == Settings::Format::WinRegistry;
+#endif
+        if (!named)
+        {
+            key = Poco::Path(rootFolder(), m_filename).toString();
+        }
+        key += '#';
+        key += std::to_string(static_cast<int>(m_format));
+        if (m_store == Settings::Store::Sharded)
+        {
+            key += "#sharded";
+        }
+        auto create = [this, &daemonAddress]() {
+            return factory(rootFolder(), m_filename, m_format, m_store, daemonAddress);
+        };
+        m_entry = SettingsRegistry::instance().acquire(key, create);
+        m_config = m_entry->config;
+        m_sharded = dynamic_cast<ShardedConfiguration*>(m_config.get());
+        m_flat = dynamic_cast<FlatConfiguration*>(m_config.get());
+    });
+    return m_config;
+}
+
+std::unique_ptr<SettingsImpl> SettingsImpl::overlay() const
+{
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> config(new OverlayConfiguration(this->config()));
+    return std::unique_ptr<SettingsImpl>(new SettingsImpl(config, m_format));
 }
 
 bool SettingsImpl::exists(const std::string& key) const
 {
-    MAP_VALUE_EXCEPTION(return m_config->has(key));
+    MAP_VALUE_EXCEPTION(return config()->has(key));
 }
 
 std::string SettingsImpl::getString(const std::string& key) const
 {
-    MAP_VALUE_EXCEPTION(return m_config->getString(key))
+    TraceSpan span("get");
+    if (m_recording)
+    {
+        record(key);
+    }
+    std::string value;
+    if (resolved(key, value) || sharded(key, value))
+    {
+        return value;
+    }
+    MAP_VALUE_EXCEPTION(return config()->getString(key))
 }
 
 int SettingsImpl::getInt(const std::string& key) const
 {
-    MAP_VALUE_EXCEPTION(return m_config->getInt(key))
+    TraceSpan span("get");
+    if (m_recording)
+    {
+        record(key);
+    }
+    int value;
+    if (resolved(key, value) || sharded(key, value))
+    {
+        return value;
+    }
+    MAP_VALUE_EXCEPTION(return config()->getInt(key))
 }
 
 double SettingsImpl::getDouble(const std::string& key) const
 {
-    MAP_VALUE_EXCEPTION(return m_config->getDouble(key))
+    TraceSpan span("get");
+    if (m_recording)
+    {
+        record(key);
+    }
+    double value;
+    if (resolved(key, value) || sharded(key, value))
+    {
+        return value;
+    }
+    MAP_VALUE_EXCEPTION(return config()->getDouble(key))
 }
 
 bool SettingsImpl::getBool(const std::string& key) const
 {
-    MAP_VALUE_EXCEPTION(return m_config->getBool(key))
+    TraceSpan span("get");
+    if (m_recording)
+    {
+        record(key);
+    }
+    bool value;
+    if (resolved(key, value) || sharded(key, value))
+    {
+        return value;
+    }
+    MAP_VALUE_EXCEPTION(return config()->getBool(key))
+}
+
+namespace
+{
+
+/**
+ * Formats a number in the text form kept by the flat stores, without the locale and without a stream
+ */
+template <typename T> std::string toText(T value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
 }
 
+} // namespace
+
+// The sharded store is written directly, the configuration setters would take the configuration lock
+
 void SettingsImpl::setBool(const std::string& key, bool value)
 {
-    m_config->setBool(key, value);
+    const auto& configuration = config();
+    if (m_sharded != nullptr)
+    {
+        m_sharded->put(key, value ? "true" : "false", true);
+    }
+    else if (m_flat != nullptr)
+    {
+        m_flat->setLiteral(key, value ? "true" : "false");
+    }
+    else
+    {
+        configuration->setBool(key, value);
+    }
+    forget(key);
 }
 
 void SettingsImpl::setDouble(const std::string& key, double value)
 {
-    m_config->setDouble(key, value);
+    const auto& configuration = config();
+    if (m_sharded != nullptr)
+    {
+        m_sharded->put(key, toText(value), true);
+    }
+    else if (m_flat != nullptr)
+    {
+        m_flat->setLiteral(key, toText(value));
+    }
+    else
+    {
+        configuration->setDouble(key, value);
+    }
+    forget(key);
 }
 
 void SettingsImpl::setInt(const std::string& key, int value)
 {
-    m_config->setInt(key, value);
+    const auto& configuration = config();
+    if (m_sharded != nullptr)
+    {
+        m_sharded->put(key, toText(value), true);
+    }
+    else if (m_flat != nullptr)
+    {
+        m_flat->setLiteral(key, toText(value));
+    }
+    else
+    {
+        configuration->setInt(key, value);
+    }
+    forget(key);
 }
 
 void SettingsImpl::setString(const std::string& key, std::string value)
 {
-    m_config->setString(key, value);
+    const auto& configuration = config();
+    if (m_sharded != nullptr)
+    {
+        m_sharded->put(key, std::move(value));
+    }
+    else
+    {
+        configuration->setString(key, value);
+    }
+    forget(key);
+}
+
+void SettingsImpl::forEach(const Settings::Visitor& callback) const
+{
+    const auto& configuration = config();
+    if (m_sharded != nullptr)
+    {
+        for (const auto& record : m_sharded->snapshot())
+        {
+            callback(record.key, record.value);
+        }
+        return;
+    }
+    if (m_flat != nullptr)
+    {
+        m_flat->forEach([&callback](const std::string& key, const std::string& value, bool) { callback(key, value); });
+        return;
+    }
+    std::function<void(const std::string&)> visit = [&configuration, &callback, &visit](const std::string& key) {
+        Poco::Util::AbstractConfiguration::Keys children;
+        configuration->keys(key, children);
+        if (children.empty())
+        {
+            if (!key.empty() && configuration->has(key))
+            {
+                callback(key, configuration->getRawString(key));
+            }
+            return;
+        }
+        for (const auto& child : children)
+        {
+            visit(key.empty() ? child : key + '.' + child);
+        }
+    };
+    visit("");
+}
+
+void SettingsImpl::forEachRecord(const SettingsReader::TypedCallback& callback) const
+{
+    config(); // resolves m_sharded and m_flat
+    if (m_sharded != nullptr)
+    {
+        for (const auto& record : m_sharded->snapshot())
+        {
+            callback(record.key, record.value, record.literal);
+        }
+        return;
+    }
+    if (m_flat != nullptr)
+    {
+        m_flat->forEach(callback);
+        return;
+    }
+    forEach([&callback](const std::string& key, const std::string& value) { callback(key, value, false); });
+}
+
+void SettingsImpl::apply(const SettingsPatch& patch)
+{
+    TraceSpan span("apply patch");
+    const auto& configuration = config();
+    // A changed value keeps its type, a JSON number stays a number
+    auto update = [this, &configuration](const std::string& key, const std::string& value) {
+        if (m_sharded != nullptr)
+        {
+            m_sharded->update(key, value);
+        }
+        else if (m_flat != nullptr)
+        {
+            m_flat->update(key, value);
+        }
+        else
+        {
+            configuration->setString(key, value);
+        }
+    };
+    for (const auto& [key, value] : patch.added)
+    {
+        update(key, value);
+    }
+    for (const auto& [key, value] : patch.changed)
+    {
+        update(key, value);
+    }
+    for (const auto& key : patch.removed)
+    {
+        configuration->remove(key);
+    }
+    forgetAll();
+    if (m_entry)
+    {
+        m_entry->edited = true;
+    }
+}
+
+void SettingsImpl::setSchema(const SettingsSchema& schema)
+{
+    m_schema = schema;
+}
+
+namespace
+{
+
+using ResolvedValue = std::variant<std::string, int, double, bool>;
+
+/**
+ * Converts a value as AbstractConfiguration::getInt() does, decimal or hexadecimal with a '0x' prefix
+ */
+bool convert(const std::string& text, int& value)
+{
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+    {
+        unsigned hex = 0;
+        if (!Poco::NumberParser::tryParseHex(text.substr(2), hex))
+        {
+            return false;
+        }
+        value = static_cast<int>(hex);
+        return true;
+    }
+    return Poco::NumberParser::tryParse(text, value);
+}
+
+/**
+ * Converts a value as AbstractConfiguration::getBool() does
+ */
+bool convert(const std::string& text, bool& value)
+{
+    int number = 0;
+    if (Poco::NumberParser::tryParse(text, number))
+    {
+        value = number != 0;
+        return true;
+    }
+    for (const auto* word : {"true", "yes", "on"})
+    {
+        if (Poco::icompare(text, word) == 0)
+        {
+            value = true;
+            return true;
+        }
+    }
+    for (const auto* word : {"false", "no", "off"})
+    {
+        if (Poco::icompare(text, word) == 0)
+        {
+            value = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks one value against its rule
+ * @param text expanded value
+ * @param rule
+ * @param value receives the converted value
+ * @return the violation, empty if the value is valid
+ */
+std::string check(const std::string& text, const SettingsSchema::Rule& rule, ResolvedValue& value)
+{
+    double number = 0;
+    switch (rule.type)
+    {
+    case SettingsSchema::Type::String:
+        value = text;
+        break;
+    case SettingsSchema::Type::Int: {
+        int converted = 0;
+        if (!convert(text, converted))
+        {
+            return "'" + text + "' is not an integer";
+        }
+        value = converted;
+        number = converted;
+        break;
+    }
+    case SettingsSchema::Type::Double: {
+        double converted = 0;
+        if (!Poco::NumberParser::tryParseFloat(text, converted))
+        {
+            return "'" + text + "' is not a number";
+        }
+        value = converted;
+        number = converted;
+        break;
+    }
+    case SettingsSchema::Type::Bool: {
+        bool converted = false;
+        if (!convert(text, converted))
+        {
+            return "'" + text + "' is not a boolean";
+        }
+        value = converted;
+        break;
+    }
+    }
+
+    // The range only applies to the numbers, the other types leave number at zero
+    auto numeric = rule.type == SettingsSchema::Type::Int || rule.type == SettingsSchema::Type::Double;
+    if (numeric && ((rule.minimum && number < *rule.minimum) || (rule.maximum && number > *rule.maximum)))
+    {
+        return text + " is out of the range [" +
+               (rule.minimum ? Poco::NumberFormatter::format(*rule.minimum) : std::string()) + ", " +
+               (rule.maximum ? Poco::NumberFormatter::format(*rule.maximum) : std::string()) + "]";
+    }
+    if (!rule.allowed.empty() && std::find(rule.allowed.begin(), rule.allowed.end(), text) == rule.allowed.end())
+    {
+        return "'" + text + "' is not one of the accepted values";
+    }
+    return {};
+}
+
+} // namespace
+
+void SettingsImpl::validate()
+{
+    TraceSpan span("validate");
+    const auto& configuration = config();
+    std::vector<std::string> violations;
+    std::vector<std::pair<std::string, ResolvedValue>> converted;
+    for (const auto& [key, rule] : m_schema->rules)
+    {
+        if (!configuration->has(key))
+        {
+            if (rule.required)
+            {
+                violations.push_back(key + ": the key is required");
+            }
+            continue;
+        }
+        ResolvedValue value;
+        auto violation = check(configuration->getString(key), rule, value);
+        if (!violation.empty())
+        {
+            violations.push_back(key + ": " + violation);
+        }
+        // A reference to another property can change without a setter on this key
+        else if (configuration->getRawString(key).find("${") == std::string::npos)
+        {
+            converted.emplace_back(key, std::move(value));
+        }
+    }
+
+    // The filesystem reads every value from its data file on each call, its values can not be kept
+    if (m_entry && m_format != Settings::Format::Filesystem && !converted.empty())
+    {
+        std::unique_lock<std::shared_mutex> lock(m_entry->resolvedMutex);
+        for (auto& [key, value] : converted)
+        {
+            m_entry->resolved.insert_or_assign(key, std::move(value));
+        }
+        m_entry->hasResolved = true;
+    }
+    if (!violations.empty())
+    {
+        throw ValidationException(std::move(violations));
+    }
+}
+
+template <typename T> bool SettingsImpl::resolved(const std::string& key, T& value) const
+{
+    config();
+    if (!m_entry || !m_entry->hasResolved)
+    {
+        return false;
+    }
+    std::shared_lock<std::shared_mutex> lock(m_entry->resolvedMutex);
+    auto found = m_entry->resolved.find(key);
+    if (found == m_entry->resolved.end())
+    {
+        return false;
+    }
+    const auto* typed = std::get_if<T>(&found->second);
+    if (typed == nullptr)
+    {
+        return false;
+    }
+    value = *typed;
+    return true;
+}
+
+void SettingsImpl::forget(const std::string& key)
+{
+    if (m_entry)
+    {
+        m_entry->edited = true;
+    }
+    if (m_entry && m_entry->hasResolved)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_entry->resolvedMutex);
+        m_entry->resolved.erase(key);
+    }
+}
+
+void SettingsImpl::forgetAll()
+{
+    if (m_entry && m_entry->hasResolved)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_entry->resolvedMutex);
+        m_entry->resolved.clear();
+    }
+}
+
+namespace
+{
+
+bool convert(const std::string& text, std::string& value)
+{
+    value = text;
+    return true;
+}
+
+bool convert(const std::string& text, double& value)
+{
+    return Poco::NumberParser::tryParseFloat(text, value);
+}
+
+} // namespace
+
+template <typename T> bool SettingsImpl::sharded(const std::string& key, T& value) const
+{
+    config();
+    if (m_sharded == nullptr)
+    {
+        return false;
+    }
+    std::string text;
+    if (!m_sharded->fetch(key, text))
+    {
+        throw NotFoundException(key);
+    }
+    // The references to other properties are expanded by the configuration
+    if (text.find("${") != std::string::npos)
+    {
+        return false;
+    }
+    if (!convert(text, value))
+    {
+        throw SyntaxException("Cannot convert '" + text + "' of the key " + key);
+    }
+    return true;
 }
 
 void SettingsImpl::createFolders()
@@ -127,43 +666,263 @@ void SettingsImpl::createFolders()
     if (m_format == project_library::Settings::Format::WinRegistry)
         return;
 #endif
-    Poco::File newFolder(m_rootFolder.toString());
+    TraceSpan span("create folders");
+    Poco::File newFolder(rootFolder().toString());
     if (!newFolder.exists())
     {
         newFolder.createDirectories();
     }
 }
 
+void SettingsImpl::recordAccessProfile()
+{
+    std::lock_guard<std::mutex> lock(m_profileMutex);
+    m_profile.clear();
+    m_profiled.clear();
+    m_recording = true;
+}
+
+void SettingsImpl::saveAccessProfile()
+{
+    std::vector<std::string> keys;
+    {
+        std::lock_guard<std::mutex> lock(m_profileMutex);
+        m_recording = false;
+        keys.swap(m_profile);
+        m_profiled.clear();
+    }
+    auto path = profilePath();
+    createFolders();
+    Poco::FileOutputStream output(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    for (const auto& key : keys)
+    {
+        output << key << '\n';
+    }
+    output.close();
+}
+
+std::string SettingsImpl::profilePath() const
+{
+    if (m_overlay || m_format == Settings::Format::Daemon)
+    {
+        throw NotImplemented("The access profile is stored next to the settings file");
+    }
+#ifdef _WIN32
+    if (m_format == Settings::Format::WinRegistry)
+    {
+        throw NotImplemented("The access profile is stored next to the settings file");
+    }
+#endif
+    return Poco::Path(rootFolder(), m_filename + ".profile").toString();
+}
+
+void SettingsImpl::record(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(m_profileMutex);
+    if (m_recording && m_profiled.insert(key).second)
+    {
+        m_profile.push_back(key);
+    }
+}
+
+namespace
+{
+
+std::atomic<std::uint64_t> warmedValues{0};
+
+} // namespace
+
+std::uint64_t SettingsImpl::warmed()
+{
+    return warmedValues.load();
+}
+
+void SettingsImpl::startPrefetch()
+{
+    // The other formats hold every value in memory once loaded, only the filesystem format reads its values lazily
+    if (m_format != Settings::Format::Filesystem)
+    {
+        return;
+    }
+    config(); // acquires the shared entry
+    std::uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_entry->mutex);
+        generation = ++m_entry->generation;
+    }
+    auto path = profilePath();
+    if (!Poco::File(path).exists())
+    {
+        return;
+    }
+    std::vector<std::string> keys;
+    {
+        Poco::FileInputStream input(path, std::ios::in | std::ios::binary);
+        std::string key;
+        while (std::getline(input, key))
+        {
+            if (!key.empty())
+            {
+                keys.push_back(key);
+            }
+        }
+    }
+    if (keys.empty())
+    {
+        return;
+    }
+    if (m_prefetch.joinable())
+    {
+        m_prefetch.join();
+    }
+    m_prefetch = std::thread([this, keys = std::move(keys), generation]() {
+        traceThreadName("settings prefetch");
+        TraceSpan span("prefetch");
+        prefetch(keys, generation);
+    });
+}
+
+void SettingsImpl::prefetch(const std::vector<std::string>& keys, std::uint64_t generation) const
+{
+    const auto& configuration = config();
+    // Every value is a file of its own, the reads are queued at once and served while the startup goes on
+    Poco::Path root(rootFolder(), m_filename);
+    root.makeDirectory();
+    for (const auto& key : keys)
+    {
+        // Same layout as FilesystemConfiguration, a folder per part of the key holding a 'data' file
+        Poco::Path file(root);
+        std::string::size_type pos = 0;
+        while (pos <= key.size())
+        {
+            auto end = std::min(key.find('.', pos), key.size());
+            file.pushDirectory(key.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        file.setFileName("data");
+        prefetchFile(file.toString());
+    }
+    // Each step runs under the load lock, a newer load() in between stops the warming
+    for (const auto& key : keys)
+    {
+        std::lock_guard<std::mutex> lock(m_entry->mutex);
+        if (m_entry->generation != generation)
+        {
+            return;
+        }
+        try
+        {
+            if (configuration->has(key))
+            {
+                ++warmedValues;
+            }
+        }
+        catch (Poco::Exception&)
+        {
+        }
+    }
+}
+
 void SettingsImpl::load()
+{
+    TraceSpan loadSpan("load");
+    if (m_overlay)
+    {
+        throw NotImplemented("An overlay is a view of its parent settings, load the parent instead");
+    }
+    read();
+    startPrefetch();
+    if (m_schema)
+    {
+        validate();
+    }
+}
+
+void SettingsImpl::read()
 {
 #ifdef _WIN32
     if (m_format == project_library::Settings::Format::WinRegistry)
         return;
 #endif
-    Poco::Path filePath(m_rootFolder, m_filename);
+    // The filesystem reads every value from its own data file
+    if (m_format == Settings::Format::Filesystem)
+    {
+        return;
+    }
+    if (m_format == Settings::Format::Daemon)
+    {
+        fetch();
+        return;
+    }
+
+    auto path = Poco::Path(rootFolder(), m_filename).toString();
+    config(); // acquires the shared entry
+    std::lock_guard<std::mutex> lock(m_entry->mutex);
     try
     {
-        switch (m_format)
-        {
-        case Settings::Format::Filesystem:
-            break;
-        case Settings::Format::IniFile:
-            m_config.cast<Poco::Util::IniFileConfiguration>()->load(filePath.toString());
-            break;
-        case Settings::Format::JSON:
-            m_config.cast<Poco::Util::JSONConfiguration>()->load(filePath.toString());
-            break;
-        case Settings::Format::XML:
-            m_config.cast<Poco::Util::XMLConfiguration>()->load(filePath.toString());
-            break;
-        case Settings::Format::PropertyFile:
-            m_config.cast<Poco::Util::PropertyFileConfiguration>()->load(filePath.toString());
-            break;
-#ifdef _WIN32
-        case Settings::Format::WinRegistry:
-            break;
-#endif
+        // Another instance already parsed the file and it did not change since then
+        Poco::Timestamp modified;
+        Poco::File::FileSize size = 0;
+        {
+            TraceSpan span("stat");
+            Poco::File file(path);
+            modified = file.getLastModified();
+            size = file.getSize();
         }
+        if (m_entry->loaded && !m_entry->edited && m_entry->modified == modified && m_entry->size == size)
+        {
+            return;
+        }
+
+        std::unique_ptr<SettingsInputFile> source;
+        {
+            TraceSpan span("open");
+            source = std::make_unique<SettingsInputFile>(path);
+        }
+        m_entry->compressed = source->compressed();
+
+        forgetAll();
+        // The parsed values replace the edits
+        m_entry->edited = false;
+        SettingsCache cache(path);
+        // The source is only hashed when the cache was written for its modification time and size
+        bool hashed = false;
+        auto hash = [&source, &hashed]() {
+            TraceSpan span("hash");
+            hashed = true;
+            return SettingsCache::hash(source->stream());
+        };
+        if (!SettingsCache::enabled())
+        {
+            TraceSpan span("parse");
+            parse(source->stream());
+        }
+        else if (!restore(cache, modified, size, hash))
+        {
+            if (hashed)
+            {
+                TraceSpan span("open");
+                source = std::make_unique<SettingsInputFile>(path);
+            }
+            // The source is hashed while it is parsed, and the cache is written from the parsed values
+            HashingInputStream input(source->stream());
+            {
+                TraceSpan span("parse");
+                parse(input);
+            }
+            auto parsedHash = input.hash();
+            TraceSpan span("store cache");
+            std::string root;
+            if (m_format == Settings::Format::XML)
+            {
+                root = m_sharded != nullptr ? m_sharded->root() : m_flat->root();
+            }
+            cache.store(modified, size, parsedHash, root,
+                        [this](const SettingsReader::TypedCallback& callback) { forEachRecord(callback); });
+        }
+        m_entry->loaded = true;
+        m_entry->modified = modified;
+        m_entry->size = size;
     }
     catch (Poco::FileNotFoundException& e)
     {
@@ -171,8 +930,130 @@ void SettingsImpl::load()
     }
 }
 
+void SettingsImpl::fetch()
+{
+    auto& configuration = config();
+    // Serializes the instances sharing the document, the later ones only pay a 304 round trip
+    std::lock_guard<std::mutex> lock(m_entry->mutex);
+    try
+    {
+        TraceSpan span("fetch");
+        auto daemon = configuration.cast<DaemonConfiguration>();
+        auto etag = daemon->etag();
+        daemon->fetch();
+        if (daemon->etag() != etag)
+        {
+            forgetAll();
+        }
+        m_entry->loaded = true;
+    }
+    catch (Poco::FileNotFoundException& e)
+    {
+        throw FileNotFound(e.displayText());
+    }
+}
+
+void SettingsImpl::parse(std::istream& input)
+{
+    const auto& configuration = config();
+    if (m_sharded != nullptr)
+    {
+        m_sharded->load(input);
+    }
+    else if (m_flat != nullptr)
+    {
+        m_flat->load(input);
+    }
+    else if (m_format == Settings::Format::IniFile)
+    {
+        configuration.cast<Poco::Util::IniFileConfiguration>()->load(input);
+    }
+}
+
+void SettingsImpl::serialize(std::ostream& output) const
+{
+    config(); // resolves m_sharded and m_flat
+    if (m_sharded != nullptr)
+    {
+        m_sharded->save(output);
+    }
+    else if (m_flat != nullptr)
+    {
+        m_flat->save(output);
+    }
+}
+
+bool SettingsImpl::restore(const SettingsCache& cache, const Poco::Timestamp& modified, Poco::File::FileSize size,
+                           const std::function<std::uint64_t()>& hash)
+{
+    TraceSpan span("restore cache");
+    const auto& configuration = config();
+    // The records are collected first, a miss leaves the values alone and a hit replaces them in a single step
+    std::vector<TypedRecord> records;
+    std::string root;
+    auto collect = [&records](const std::string& key, const std::string& value, bool literal) {
+        records.push_back({key, value, literal});
+    };
+    if (!cache.restore(modified, size, hash, root, collect))
+    {
+        return false;
+    }
+    if (m_sharded != nullptr)
+    {
+        m_sharded->replace(std::move(records));
+        if (m_format == Settings::Format::XML)
+        {
+            m_sharded->setRoot(root);
+        }
+    }
+    else if (m_flat != nullptr)
+    {
+        m_flat->replace(std::move(records));
+        if (m_format == Settings::Format::XML)
+        {
+            m_flat->setRoot(root);
+        }
+    }
+    else
+    {
+        // Parsing an empty document drops the previous values of a reloaded file
+        std::istringstream empty;
+        parse(empty);
+        for (const auto& record : records)
+        {
+            configuration->setString(record.key, record.value);
+        }
+    }
+    return true;
+}
+
+namespace
+{
+
+void removeFile(const std::string& path)
+{
+    try
+    {
+        Poco::File file(path);
+        if (file.exists())
+        {
+            file.remove();
+        }
+    }
+    catch (Poco::Exception&)
+    {
+    }
+}
+
+} // namespace
+
 void SettingsImpl::save()
 {
+    TraceSpan saveSpan("save");
+    if (m_overlay)
+    {
+        throw NotImplemented("An overlay is a view of its parent settings, save the parent instead");
+    }
 #ifdef _WIN32
     if (m_format == project_library::Settings::Format::WinRegistry)
         return;
@@ -187,31 +1068,49 @@ void SettingsImpl::save()
     {
         return;
     }
+    if (m_format == Settings::Format::Daemon)
+    {
+        TraceSpan span("push");
+        config().cast<DaemonConfiguration>()->push();
+        return;
+    }
 
-    Poco::Path filePath(m_rootFolder, m_filename);
-    auto value = filePath.toString();
-    Poco::FileOutputStream fos(value);
+    auto path = Poco::Path(rootFolder(), m_filename).toString();
+    config(); // acquires the shared entry
+    std::lock_guard<std::mutex> lock(m_entry->mutex);
+    if (!m_entry->foldersCreated)
+    {
+        createFolders();
+        m_entry->foldersCreated = true;
+    }
 
-    switch (m_format)
+    TraceSpan span("serialize");
+    // Written next to the file and renamed over it, a failure while serializing leaves the previous file as it was
+    auto temporary = Poco::TemporaryFile::tempName(Poco::Path(path).parent().toString());
+    // Cleared before serializing, an edit made meanwhile is not in the file and sets it again
+    m_entry->edited = false;
+    try
     {
-    case Settings::Format::IniFile:
-        break;
-    case Settings::Format::Filesystem:
-        break;
-    case Settings::Format::JSON:
-        m_config.cast<Poco::Util::JSONConfiguration>()->save(fos);
-        break;
-    case Settings::Format::XML:
-        m_config.cast<Poco::Util::XMLConfiguration>()->save(fos);
-        break;
-    case Settings::Format::PropertyFile:
-        m_config.cast<Poco::Util::PropertyFileConfiguration>()->save(fos);
-        break;
-#ifdef _WIN32
-    case Settings::Format::WinRegistry:
-        break;
-#endif
+        {
+            SettingsOutputFile target(temporary,
+                                      m_entry->compressed || SettingsOutputFile::hasCompressedSuffix(m_filename));
+            serialize(target.stream());
+            target.close();
+        }
+        Poco::File(temporary).renameTo(path);
     }
+    catch (...)
+    {
+        m_entry->edited = true;
+        removeFile(temporary);
+        throw;
+    }
+
+    // The saved file matches the shared configuration, the other instances do not need to parse it again
+    Poco::File file(path);
+    m_entry->loaded = true;
+    m_entry->modified = file.getLastModified();
+    m_entry->size = file.getSize();
 }
 
 } // namespace project_library
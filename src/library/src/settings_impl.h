@@ -8,9 +8,24 @@
 #include "Poco/AutoPtr.h"
 #include "Poco/Path.h"
 #include "Poco/Util/AbstractConfiguration.h"
+#include "flat_configuration.h"
 #include "settings.h"
+#include "settings_cache.h"
+#include "settings_registry.h"
+#include "settings_schema.h"
+#include "sharded_configuration.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <istream>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 namespace project_library
 {
@@ -24,9 +39,15 @@ class SettingsImpl
      * this is the '~/.config/'. On Windows systems, this is '%APPDATA%' (typically C:\Users\user\AppData\Roaming).
      * @param filename filename that store the settings
      * @param pathSuffix is a suffix to add to the path
+     * @param store how the values are kept in memory
      */
     explicit SettingsImpl(const std::string& filename, const std::string& pathSuffix, const bool inConfigHome,
-                          Settings::Format format) noexcept;
+                          Settings::Format format, Settings::Store store = Settings::Store::Document) noexcept;
+
+    /**
+     * Destructor, it waits for the warming of the access profile
+     */
+    ~SettingsImpl();
 
     /**
      * Returns the boolean value of the property with the given name. If the value contains references
@@ -107,7 +128,8 @@ class SettingsImpl
     bool exists(const std::string& key) const;
 
     /**
-     * Load the values from the config source
+     * Load the values from the config source and check them against the schema
+     * @throw ValidationException if the values do not match the schema
      */
     void load();
 
@@ -116,17 +138,191 @@ class SettingsImpl
      */
     void save();
 
+    /**
+     * Creates a copy-on-write view that shares the configuration of this instance
+     * @return the child implementation
+     */
+    std::unique_ptr<SettingsImpl> overlay() const;
+
+    /**
+     * Visits every key that holds a value, with its raw value
+     * @param callback
+     */
+    void forEach(const Settings::Visitor& callback) const;
+
+    /**
+     * Sets the added and changed keys of a patch and removes its removed keys
+     * @param patch
+     */
+    void apply(const SettingsPatch& patch);
+
+    /**
+     * Sets the schema checked by load()
+     * @param schema
+     */
+    void setSchema(const SettingsSchema& schema);
+
+    /**
+     * Starts recording the keys read by the getters
+     */
+    void recordAccessProfile();
+
+    /**
+     * Stops the recording and saves the recorded keys
+     * @throw NotImplemented if the settings are not stored in files
+     */
+    void saveAccessProfile();
+
+    /**
+     * @return the values warmed from the access profiles by the process
+     */
+    static std::uint64_t warmed();
+
   private:
+    /**
+     * Overlay constructor
+     * @param config configuration of the overlay, already chained to its parent
+     * @param format format of the parent
+     */
+    SettingsImpl(Poco::AutoPtr<Poco::Util::AbstractConfiguration> config, Settings::Format format) noexcept;
+
+    /**
+     * @return the configuration, shared through the registry with the instances that use the same source. It is
+     * acquired on first use.
+     */
+    const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config() const;
+
+    /**
+     * @return the folder that stores the settings, resolved on first use
+     */
+    const Poco::Path& rootFolder() const;
+
     /**
      * Create the necessary folders to store the settings
      */
     void createFolders();
 
-    Poco::AutoPtr<Poco::Util::AbstractConfiguration> m_config;
+    /**
+     * Downloads the values of a Format::Daemon document, shared by every instance of the same document
+     * @throw FileNotFound if the daemon does not have the document
+     * @throw ConnectionError if the daemon can not be reached
+     */
+    void fetch();
+
+    /**
+     * Reads the config source, unless it did not change since it was read
+     */
+    void read();
+
+    /**
+     * Parses the content of the config source
+     * @param input
+     */
+    void parse(std::istream& input);
+
+    /**
+     * Writes the values in the format of the config source
+     * @param output
+     */
+    void serialize(std::ostream& output) const;
+
+    /**
+     * Replaces the values with the records of the pre-parsed copy of the config source
+     * @param cache pre-parsed copy
+     * @param modified modification time of the source
+     * @param size size of the source
+     * @param hash returns the hash of the source content, only called if the copy has the same modification time and
+     * size
+     * @return false if the copy does not match the source, the values are not changed
+     */
+    bool restore(const SettingsCache& cache, const Poco::Timestamp& modified, Poco::File::FileSize size,
+                 const std::function<std::uint64_t()>& hash);
+
+    /**
+     * Checks every rule of the schema and keeps the converted values of the valid keys in the shared entry
+     * @throw ValidationException with all the violations
+     */
+    void validate();
+
+    /**
+     * Looks up a value converted by the validation
+     * @param key
+     * @param value receives the value if it was converted to the type T
+     * @return true if the value was found
+     */
+    template <typename T> bool resolved(const std::string& key, T& value) const;
+
+    /**
+     * Reads a value from the sharded store without taking the configuration lock
+     * @param key
+     * @param value receives the converted value
+     * @return false if the store is not sharded or the value references other properties
+     * @throw NotFoundException if the key does not exist
+     * @throw SyntaxException if the value can not be converted
+     */
+    template <typename T> bool sharded(const std::string& key, T& value) const;
+
+    /**
+     * Drops the converted value of a key and marks the values as edited, it must be called by every change of a value
+     * @param key
+     */
+    void forget(const std::string& key);
+
+    /**
+     * Drops every converted value
+     */
+    void forgetAll();
+
+    /**
+     * Visits every value with its type, as kept by the parse cache
+     * @param callback is called once for every key
+     */
+    void forEachRecord(const SettingsReader::TypedCallback& callback) const;
+
+    /**
+     * @return the file that stores the access profile
+     */
+    std::string profilePath() const;
+
+    /**
+     * Adds a key to the access profile being recorded
+     * @param key
+     */
+    void record(const std::string& key) const;
+
+    /**
+     * Starts warming the keys of the saved access profile on a background thread, only the filesystem format reads
+     * its values after load()
+     */
+    void startPrefetch();
+
+    /**
+     * Warms the keys of an access profile
+     * @param keys
+     * @param generation load generation of the entry when the warming started
+     */
+    void prefetch(const std::vector<std::string>& keys, std::uint64_t generation) const;
+
+    mutable std::once_flag m_configOnce;
+    mutable Poco::AutoPtr<Poco::Util::AbstractConfiguration> m_config;
+    mutable std::shared_ptr<SettingsRegistry::Entry> m_entry;
     std::string m_filename;
     std::string m_suffix;
+    bool m_inConfigHome = true;
     Settings::Format m_format;
-    Poco::Path m_rootFolder;
+    Settings::Store m_store = Settings::Store::Document;
+    mutable ShardedConfiguration* m_sharded = nullptr;
+    mutable FlatConfiguration* m_flat = nullptr;
+    mutable std::once_flag m_rootFolderOnce;
+    mutable Poco::Path m_rootFolder;
+    bool m_overlay = false;
+    std::optional<SettingsSchema> m_schema;
+
+    mutable std::atomic<bool> m_recording{false};
+    mutable std::mutex m_profileMutex;
+    mutable std::vector<std::string> m_profile;
+    mutable std::unordered_set<std::string> m_profiled;
+    std::thread m_prefetch;
 };
 
 } // namespace project_library
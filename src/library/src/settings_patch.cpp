@@ -0,0 +1,212 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "settings_patch.h"
+#include "settings_stream.h"
+
+namespace project_library
+{
+
+namespace
+{
+
+using KeyValues = std::map<std::string, std::string>;
+
+void escape(const std::string& text, std::string& out)
+{
+    for (auto c : text)
+    {
+        switch (c)
+        {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        default:
+            out += c;
+        }
+    }
+}
+
+std::string unescape(const std::string& data, std::size_t begin, std::size_t end)
+{
+    std::string out;
+    out.reserve(end - begin);
+    for (auto pos = begin; pos < end; ++pos)
+    {
+        if (data[pos] != '\\')
+        {
+            out += data[pos];
+            continue;
+        }
+        if (++pos == end)
+        {
+            throw SyntaxException("Truncated escape sequence in settings patch");
+        }
+        switch (data[pos])
+        {
+        case 't':
+            out += '\t';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        default:
+            out += data[pos];
+        }
+    }
+    return out;
+}
+
+/**
+ * Merges two sorted key sets, both are walked once
+ */
+SettingsPatch compare(const KeyValues& from, const KeyValues& to)
+{
+    SettingsPatch patch;
+    auto oldIt = from.begin();
+    auto newIt = to.begin();
+    while (oldIt != from.end() || newIt != to.end())
+    {
+        if (newIt == to.end() || (oldIt != from.end() && oldIt->first < newIt->first))
+        {
+            patch.removed.push_back(oldIt->first);
+            ++oldIt;
+        }
+        else if (oldIt == from.end() || newIt->first < oldIt->first)
+        {
+            patch.added.emplace_hint(patch.added.end(), *newIt);
+            ++newIt;
+        }
+        else
+        {
+            if (oldIt->second != newIt->second)
+            {
+                patch.changed.emplace_hint(patch.changed.end(), *newIt);
+            }
+            ++oldIt;
+            ++newIt;
+        }
+    }
+    return patch;
+}
+
+KeyValues collect(const Settings& settings)
+{
+    KeyValues values;
+    settings.forEach([&values](const std::string& key, const std::string& value) { values[key] = value; });
+    return values;
+}
+
+KeyValues collect(const std::string& path, Settings::Format format)
+{
+    KeyValues values;
+    auto reader = openReader(path, format);
+    reader->read([&values](const std::string& key, const std::string& value) { values[key] = value; });
+    return values;
+}
+
+} // namespace
+
+bool SettingsPatch::empty() const
+{
+    return added.empty() && changed.empty() && removed.empty();
+}
+
+std::size_t SettingsPatch::size() const
+{
+    return added.size() + changed.size() + removed.size();
+}
+
+std::string SettingsPatch::serialize() const
+{
+    std::string out;
+    auto write = [&out](char operation, const std::string& key, const std::string* value) {
+        out += operation;
+        escape(key, out);
+        if (value != nullptr)
+        {
+            out += '\t';
+            escape(*value, out);
+        }
+        out += '\n';
+    };
+    for (const auto& [key, value] : added)
+    {
+        write('+', key, &value);
+    }
+    for (const auto& [key, value] : changed)
+    {
+        write('~', key, &value);
+    }
+    for (const auto& key : removed)
+    {
+        write('-', key, nullptr);
+    }
+    return out;
+}
+
+SettingsPatch SettingsPatch::parse(const std::string& data)
+{
+    SettingsPatch patch;
+    std::size_t pos = 0;
+    while (pos < data.size())
+    {
+        auto end = data.find('\n', pos);
+        if (end == std::string::npos)
+        {
+            end = data.size();
+        }
+        if (end > pos)
+        {
+            auto operation = data[pos];
+            auto separator = data.find('\t', pos);
+            if (separator > end)
+            {
+                separator = end;
+            }
+            auto key = unescape(data, pos + 1, separator);
+            if (operation == '-' && separator == end)
+            {
+                patch.removed.push_back(key);
+            }
+            else if ((operation == '+' || operation == '~') && separator < end)
+            {
+                auto& target = operation == '+' ? patch.added : patch.changed;
+                target[key] = unescape(data, separator + 1, end);
+            }
+            else
+            {
+                throw SyntaxException("Invalid settings patch line: " + data.substr(pos, end - pos));
+            }
+        }
+        pos = end + 1;
+    }
+    return patch;
+}
+
+SettingsPatch diff(const Settings& from, const Settings& to)
+{
+    return compare(collect(from), collect(to));
+}
+
+SettingsPatch diff(const std::string& fromPath, const std::string& toPath, Settings::Format format)
+{
+    return compare(collect(fromPath, format), collect(toPath, format));
+}
+
+} // namespace project_library
@@ -0,0 +1,781 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "Poco/DirectoryIterator.h"
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/FileStream.h"
+#include "Poco/Path.h"
+#include "Poco/SAX/Attributes.h"
+#include "Poco/SAX/DefaultHandler.h"
+#include "Poco/SAX/InputSource.h"
+#include "Poco/SAX/SAXParser.h"
+#include "Poco/String.h"
+#include "Poco/XML/XMLException.h"
+#include "settings_file.h"
+#include "settings_stream_impl.h"
+#include <cctype>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace project_library
+{
+
+namespace
+{
+
+constexpr int eof = std::char_traits<char>::eof();
+
+bool isSpace(int c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+/**
+ * Pull parser for JSON documents, nested objects are joined with '.' and array elements use the '[index]' suffix,
+ * the same mapping used by Poco::Util::JSONConfiguration.
+ */
+class JsonReader : public SettingsReader
+{
+  public:
+    explicit JsonReader(std::istream& in) : m_buf(in.rdbuf())
+    {
+    }
+
+    void read(const Callback& callback) override
+    {
+        readTyped([&callback](const std::string& key, const std::string& value, bool) { callback(key, value); });
+    }
+
+    void readTyped(const TypedCallback& callback) override
+    {
+        m_callback = &callback;
+        skipWhitespace();
+        expect('{');
+        parseObject();
+        skipWhitespace();
+        if (peek() != eof)
+        {
+            error("unexpected characters after the root object");
+        }
+    }
+
+  private:
+    int peek()
+    {
+        return m_buf->sgetc();
+    }
+
+    int get()
+    {
+        int c = m_buf->sbumpc();
+        if (c != eof)
+        {
+            ++m_offset;
+        }
+        return c;
+    }
+
+    void skipWhitespace()
+    {
+        while (isSpace(peek()))
+        {
+            get();
+        }
+    }
+
+    void expect(char expected)
+    {
+        if (get() != expected)
+        {
+            error(std::string("expected '") + expected + "'");
+        }
+    }
+
+    [[noreturn]] void error(const std::string& message) const
+    {
+        throw SyntaxException("JSON syntax error at offset " + std::to_string(m_offset) + ": " + message);
+    }
+
+    void parseValue()
+    {
+        skipWhitespace();
+        switch (peek())
+        {
+        case '{':
+            get();
+            parseObject();
+            break;
+        case '[':
+            get();
+            parseArray();
+            break;
+        case '"':
+            get();
+            parseString(m_value);
+            (*m_callback)(m_key, m_value, false);
+            break;
+        default:
+            // A null reads as an empty string
+            parseLiteral(m_value);
+            (*m_callback)(m_key, m_value, !m_value.empty());
+            break;
+        }
+    }
+
+    void parseObject()
+    {
+        skipWhitespace();
+        if (peek() == '}')
+        {
+            get();
+            return;
+        }
+        for (;;)
+        {
+            skipWhitespace();
+            expect('"');
+            parseString(m_name);
+            skipWhitespace();
+            expect(':');
+
+            auto length = m_key.size();
+            if (length > 0)
+            {
+                m_key += '.';
+            }
+            m_key += m_name;
+            parseValue();
+            m_key.resize(length);
+
+            skipWhitespace();
+            int c = get();
+            if (c == '}')
+            {
+                return;
+            }
+            if (c != ',')
+            {
+                error("expected ',' or '}'");
+            }
+        }
+    }
+
+    void parseArray()
+    {
+        skipWhitespace();
+        if (peek() == ']')
+        {
+            get();
+            return;
+        }
+        for (std::size_t index = 0;; ++index)
+        {
+            auto length = m_key.size();
+            m_key += '[';
+            m_key += std::to_string(index);
+            m_key += ']';
+            parseValue();
+            m_key.resize(length);
+
+            skipWhitespace();
+            int c = get();
+            if (c == ']')
+            {
+                return;
+            }
+            if (c != ',')
+            {
+                error("expected ',' or ']'");
+            }
+        }
+    }
+
+    void parseLiteral(std::string& out)
+    {
+        out.clear();
+        int c = peek();
+        while (c != eof && (std::isalnum(c) != 0 || c == '-' || c == '+' || c == '.'))
+        {
+            out += static_cast<char>(get());
+            c = peek();
+        }
+        if (out == "null")
+        {
+            out.clear();
+        }
+        else if (out.empty() || (out != "true" && out != "false" && out[0] != '-' && std::isdigit(out[0]) == 0))
+        {
+            error("invalid value");
+        }
+    }
+
+    void parseString(std::string& out)
+    {
+        out.clear();
+        for (;;)
+        {
+            int c = get();
+            if (c == eof)
+            {
+                error("unterminated string");
+            }
+            if (c == '"')
+            {
+                return;
+            }
+            if (c != '\\')
+            {
+                out += static_cast<char>(c);
+                continue;
+            }
+            c = get();
+            switch (c)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                out += static_cast<char>(c);
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+                appendCodePoint(out);
+                break;
+            default:
+                error("invalid escape sequence");
+            }
+        }
+    }
+
+    unsigned parseHex()
+    {
+        unsigned value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            int c = get();
+            value <<= 4U;
+            if (c >= '0' && c <= '9')
+            {
+                value |= static_cast<unsigned>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                value |= static_cast<unsigned>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                value |= static_cast<unsigned>(c - 'A' + 10);
+            }
+            else
+            {
+                error("invalid unicode escape");
+            }
+        }
+        return value;
+    }
+
+    void appendCodePoint(std::string& out)
+    {
+        unsigned code = parseHex();
+        if (code >= 0xD800 && code <= 0xDBFF)
+        {
+            expect('\\');
+            expect('u');
+            unsigned low = parseHex();
+            if (low < 0xDC00 || low > 0xDFFF)
+            {
+                error("invalid surrogate pair");
+            }
+            code = 0x10000 + ((code - 0xD800) << 10U) + (low - 0xDC00);
+        }
+        if (code < 0x80)
+        {
+            out += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (code >> 6U));
+            out += static_cast<char>(0x80 | (code & 0x3FU));
+        }
+        else if (code < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (code >> 12U));
+            out += static_cast<char>(0x80 | ((code >> 6U) & 0x3FU));
+            out += static_cast<char>(0x80 | (code & 0x3FU));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (code >> 18U));
+            out += static_cast<char>(0x80 | ((code >> 12U) & 0x3FU));
+            out += static_cast<char>(0x80 | ((code >> 6U) & 0x3FU));
+            out += static_cast<char>(0x80 | (code & 0x3FU));
+        }
+    }
+
+    std::streambuf* m_buf;
+    const TypedCallback* m_callback = nullptr;
+    std::size_t m_offset = 0;
+    std::string m_key;
+    std::string m_name;
+    std::string m_value;
+};
+
+/**
+ * Line reader for legacy Windows initialization files, it follows the rules of Poco::Util::IniFileConfiguration.
+ */
+class IniFileReader : public SettingsReader
+{
+  public:
+    explicit IniFileReader(std::istream& in) : m_buf(in.rdbuf())
+    {
+    }
+
+    void read(const Callback& callback) override
+    {
+        std::string section;
+        std::string key;
+        std::string value;
+        int c = m_buf->sbumpc();
+        while (c != eof)
+        {
+            while (c != eof && isSpace(c))
+            {
+                c = m_buf->sbumpc();
+            }
+            if (c == eof)
+            {
+                break;
+            }
+            if (c == ';')
+            {
+                while (c != eof && c != '\n')
+                {
+                    c = m_buf->sbumpc();
+                }
+            }
+            else if (c == '[')
+            {
+                section.clear();
+                c = m_buf->sbumpc();
+                while (c != eof && c != ']' && c != '\n')
+                {
+                    section += static_cast<char>(c);
+                    c = m_buf->sbumpc();
+                }
+                Poco::trimInPlace(section);
+                c = m_buf->sbumpc();
+            }
+            else
+            {
+                key = section;
+                if (!key.empty())
+                {
+                    key += '.';
+                }
+                std::string name;
+                while (c != eof && c != '=' && c != '\n')
+                {
+                    name += static_cast<char>(c);
+                    c = m_buf->sbumpc();
+                }
+                key += Poco::trim(name);
+                value.clear();
+                if (c == '=')
+                {
+                    c = m_buf->sbumpc();
+                    while (c != eof && c != '\n')
+                    {
+                        value += static_cast<char>(c);
+                        c = m_buf->sbumpc();
+                    }
+                }
+                callback(key, Poco::trim(value));
+            }
+        }
+    }
+
+  private:
+    std::streambuf* m_buf;
+};
+
+/**
+ * Line reader for Java-style property files, it follows the rules of Poco::Util::PropertyFileConfiguration.
+ */
+class PropertyFileReader : public SettingsReader
+{
+  public:
+    explicit PropertyFileReader(std::istream& in) : m_buf(in.rdbuf())
+    {
+    }
+
+    void read(const Callback& callback) override
+    {
+        std::string key;
+        std::string value;
+        int c = m_buf->sbumpc();
+        while (c != eof)
+        {
+            while (c != eof && isSpace(c))
+            {
+                c = m_buf->sbumpc();
+            }
+            if (c == eof)
+            {
+                break;
+            }
+            if (c == '#' || c == '!')
+            {
+                while (c != eof && c != '\n' && c != '\r')
+                {
+                    c = m_buf->sbumpc();
+                }
+                continue;
+            }
+            key.clear();
+            std::size_t escaped = 0;
+            while (c != eof && c != '=' && c != ':' && c != '\r' && c != '\n')
+            {
+                if (c == '\\')
+                {
+                    c = m_buf->sbumpc();
+                    if (c == eof)
+                    {
+                        break;
+                    }
+                    key += unescape(c);
+                    escaped = key.size();
+                }
+                else
+                {
+                    key += static_cast<char>(c);
+                }
+                c = m_buf->sbumpc();
+            }
+            // An escaped space at the end belongs to the key
+            while (key.size() > escaped && isSpace(static_cast<unsigned char>(key.back())))
+            {
+                key.pop_back();
+            }
+            value.clear();
+            if (c == '=' || c == ':')
+            {
+                for (c = readChar(); c > 0; c = readChar())
+                {
+                    value += static_cast<char>(c);
+                }
+            }
+            callback(key, Poco::trim(value));
+            c = m_buf->sbumpc();
+        }
+    }
+
+  private:
+    /**
+     * @param c character that follows a backslash
+     * @return the character of the escape sequence
+     */
+    static char unescape(int c)
+    {
+        switch (c)
+        {
+        case 't':
+            return '\t';
+        case 'r':
+            return '\r';
+        case 'n':
+            return '\n';
+        case 'f':
+            return '\f';
+        default:
+            return static_cast<char>(c);
+        }
+    }
+
+    /**
+     * @return the next character with escape sequences and line continuations resolved, 0 at the end of the line
+     */
+    int readChar()
+    {
+        for (;;)
+        {
+            int c = m_buf->sbumpc();
+            if (c == '\\')
+            {
+                c = m_buf->sbumpc();
+                switch (c)
+                {
+                case 't':
+                    return '\t';
+                case 'r':
+                    return '\r';
+                case 'n':
+                    return '\n';
+                case 'f':
+                    return '\f';
+                case '\r':
+                    if (m_buf->sgetc() == '\n')
+                    {
+                        m_buf->sbumpc();
+                    }
+                    continue;
+                case '\n':
+                    continue;
+                default:
+                    return c == eof ? 0 : c;
+                }
+            }
+            if (c == '\n' || c == '\r' || c == eof)
+            {
+                return 0;
+            }
+            return c;
+        }
+    }
+
+    std::streambuf* m_buf;
+};
+
+/**
+ * SAX handler that maps elements and attributes to the keys used by Poco::Util::XMLConfiguration: the root element
+ * is not part of the key, repeated siblings are addressed as 'name[index]' and attributes as 'name[@attribute]'.
+ */
+class XmlHandler : public Poco::XML::DefaultHandler
+{
+  public:
+    XmlHandler(const SettingsReader::Callback& callback, std::string* root) : m_callback(callback), m_root(root)
+    {
+    }
+
+    void startElement(const Poco::XML::XMLString& /*uri*/, const Poco::XML::XMLString& localName,
+                      const Poco::XML::XMLString& qname, const Poco::XML::Attributes& attributes) override
+    {
+        const auto& name = qname.empty() ? localName : qname;
+        Element element;
+        element.keyLength = m_key.size();
+        if (m_stack.empty() && m_root != nullptr)
+        {
+            *m_root = name;
+        }
+        if (!m_stack.empty())
+        {
+            auto& parent = m_stack.back();
+            parent.hasChildren = true;
+            auto index = parent.siblings[name]++;
+            if (!m_key.empty())
+            {
+                m_key += '.';
+            }
+            m_key += name;
+            if (index > 0)
+            {
+                m_key += '[';
+                m_key += std::to_string(index);
+                m_key += ']';
+            }
+        }
+        for (int i = 0; i < attributes.getLength(); ++i)
+        {
+            m_callback(m_key + "[@" + attributes.getQName(i) + "]", attributes.getValue(i));
+        }
+        m_stack.push_back(std::move(element));
+    }
+
+    void endElement(const Poco::XML::XMLString& /*uri*/, const Poco::XML::XMLString& /*localName*/,
+                    const Poco::XML::XMLString& /*qname*/) override
+    {
+        auto& element = m_stack.back();
+        if (!element.hasChildren && m_stack.size() > 1)
+        {
+            m_callback(m_key, element.text);
+        }
+        m_key.resize(element.keyLength);
+        m_stack.pop_back();
+    }
+
+    void characters(const Poco::XML::XMLChar ch[], int start, int length) override
+    {
+        if (!m_stack.empty())
+        {
+            m_stack.back().text.append(ch + start, static_cast<std::size_t>(length));
+        }
+    }
+
+  private:
+    struct Element
+    {
+        std::size_t keyLength = 0;
+        bool hasChildren = false;
+        std::string text;
+        std::map<std::string, int> siblings;
+    };
+
+    const SettingsReader::Callback& m_callback;
+    std::string* m_root;
+    std::vector<Element> m_stack;
+    std::string m_key;
+};
+
+/**
+ * SAX reader for XML documents, only the open elements are kept in memory.
+ */
+class XmlReader : public SettingsReader
+{
+  public:
+    XmlReader(std::istream& in, std::string* root) : m_in(in), m_root(root)
+    {
+    }
+
+    void read(const Callback& callback) override
+    {
+        XmlHandler handler(callback, m_root);
+        Poco::XML::SAXParser parser;
+        parser.setFeature(Poco::XML::XMLReader::FEATURE_NAMESPACES, false);
+        parser.setContentHandler(&handler);
+        Poco::XML::InputSource source(m_in);
+        try
+        {
+            parser.parse(&source);
+        }
+        catch (Poco::XML::XMLException& e)
+        {
+            throw SyntaxException(e.displayText());
+        }
+    }
+
+  private:
+    std::istream& m_in;
+    std::string* m_root;
+};
+
+/**
+ * Walks the folder tree created by Poco::Util::FilesystemConfiguration, every 'data' file holds the value of the key
+ * formed by the folder names that lead to it.
+ */
+class FilesystemReader : public SettingsReader
+{
+  public:
+    explicit FilesystemReader(const std::string& root) : m_root(root)
+    {
+    }
+
+    void read(const Callback& callback) override
+    {
+        std::string key;
+        walk(Poco::Path(m_root).makeDirectory(), key, callback);
+    }
+
+  private:
+    void walk(const Poco::Path& folder, std::string& key, const Callback& callback)
+    {
+        Poco::DirectoryIterator end;
+        for (Poco::DirectoryIterator it(folder); it != end; ++it)
+        {
+            if (it->isDirectory())
+            {
+                auto length = key.size();
+                if (length > 0)
+                {
+                    key += '.';
+                }
+                key += it.name();
+                walk(Poco::Path(it.path()).makeDirectory(), key, callback);
+                key.resize(length);
+            }
+            else if (it.name() == "data" && !key.empty())
+            {
+                std::string value;
+                value.reserve(static_cast<std::size_t>(it->getSize()));
+                Poco::FileInputStream istr(it.path().toString());
+                value.assign(std::istreambuf_iterator<char>(istr), std::istreambuf_iterator<char>());
+                callback(key, value);
+            }
+        }
+    }
+
+    std::string m_root;
+};
+
+/**
+ * Keeps the file opened by openReader() alive as long as the reader, compressed files are decompressed on the fly
+ */
+class FileReader : public SettingsReader
+{
+  public:
+    FileReader(const std::string& path, Settings::Format format)
+        : m_file(path), m_reader(createReader(m_file.stream(), format))
+    {
+    }
+
+    void read(const Callback& callback) override
+    {
+        m_reader->read(callback);
+    }
+
+    void readTyped(const TypedCallback& callback) override
+    {
+        m_reader->readTyped(callback);
+    }
+
+  private:
+    SettingsInputFile m_file;
+    std::unique_ptr<SettingsReader> m_reader;
+};
+
+} // namespace
+
+std::unique_ptr<SettingsReader> createReader(std::istream& in, Settings::Format format, std::string* root)
+{
+    switch (format)
+    {
+    case Settings::Format::JSON:
+        return std::make_unique<JsonReader>(in);
+    case Settings::Format::IniFile:
+        return std::make_unique<IniFileReader>(in);
+    case Settings::Format::XML:
+        return std::make_unique<XmlReader>(in, root);
+    case Settings::Format::PropertyFile:
+        return std::make_unique<PropertyFileReader>(in);
+    default:
+        throw NotImplemented("This settings format is not stored in a stream");
+    }
+}
+
+std::unique_ptr<SettingsReader> openReader(const std::string& path, Settings::Format format)
+{
+    try
+    {
+        if (format == Settings::Format::Filesystem)
+        {
+            if (!Poco::File(path).exists())
+            {
+                throw FileNotFound(path);
+            }
+            return std::make_unique<FilesystemReader>(path);
+        }
+        return std::make_unique<FileReader>(path, format);
+    }
+    catch (Poco::FileNotFoundException& e)
+    {
+        throw FileNotFound(e.displayText());
+    }
+}
+
+} // namespace project_library
@@ -0,0 +1,38 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "settings_registry.h"
+#include <iterator>
+
+namespace project_library
+{
+
+SettingsRegistry& SettingsRegistry::instance()
+{
+    static SettingsRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<SettingsRegistry::Entry> SettingsRegistry::acquire(const std::string& key, const Factory& factory)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& slot = m_entries[key];
+    auto entry = slot.lock();
+    if (!entry)
+    {
+        // Drop the entries of the sources that are no longer used
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            it = it->second.expired() && it->first != key ? m_entries.erase(it) : std::next(it);
+        }
+        entry = std::make_shared<Entry>();
+        entry->config = factory();
+        slot = entry;
+    }
+    return entry;
+}
+
+} // namespace project_library
@@ -0,0 +1,101 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/AutoPtr.h"
+#include "Poco/File.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Util/AbstractConfiguration.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+namespace project_library
+{
+
+/**
+ * Process-wide registry of the parsed configurations. The Settings instances that point to the same source share one
+ * entry, so the source is parsed once while it does not change on disk. An entry lives while any instance uses it.
+ */
+class SettingsRegistry
+{
+  public:
+    /**
+     * Configuration shared by the instances of one source
+     */
+    struct Entry
+    {
+        Poco::AutoPtr<Poco::Util::AbstractConfiguration> config;
+
+        /**
+         * Serializes the load and save operations on the entry
+         */
+        std::mutex mutex;
+
+        /**
+         * State of the source when it was last parsed or saved, valid when loaded is true
+         */
+        bool loaded = false;
+        Poco::Timestamp modified;
+        Poco::File::FileSize size = 0;
+
+        /**
+         * Set by the setters, cleared when the source is parsed or saved. load() parses the source again while it is
+         * set, even if the file did not change
+         */
+        std::atomic<bool> edited{false};
+
+        bool compressed = false;
+        bool foldersCreated = false;
+
+        /**
+         * Incremented under the mutex by every load() of the filesystem format, the warming of an access profile stops
+         * once it changes
+         */
+        std::uint64_t generation = 0;
+
+        /**
+         * Values converted by the schema validation, a setter drops the value of its key
+         */
+        std::shared_mutex resolvedMutex;
+        std::unordered_map<std::string, std::variant<std::string, int, double, bool>> resolved;
+
+        /**
+         * False while no value was ever converted, the getters and setters then skip the lock of the converted values
+         */
+        std::atomic<bool> hasResolved{false};
+    };
+
+    using Factory = std::function<Poco::AutoPtr<Poco::Util::AbstractConfiguration>()>;
+
+    /**
+     * @return the registry of the process
+     */
+    static SettingsRegistry& instance();
+
+    /**
+     * Returns the entry of a source, creating it if no instance is using it
+     * @param key identifies the source, usually its resolved path and format
+     * @param factory creates the configuration of a new entry
+     * @return the shared entry
+     */
+    std::shared_ptr<Entry> acquire(const std::string& key, const Factory& factory);
+
+  private:
+    SettingsRegistry() = default;
+
+    std::mutex m_mutex;
+    std::map<std::string, std::weak_ptr<Entry>> m_entries;
+};
+
+} // namespace project_library
@@ -0,0 +1,53 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "settings_stream.h"
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace project_library
+{
+
+/**
+ * Name of the root element of the XML documents written without a name of their own
+ */
+constexpr char defaultXmlRoot[] = "config";
+
+/**
+ * Record kept by the flat stores and their caches, literal is true for a JSON number or boolean
+ */
+struct TypedRecord
+{
+    std::string key;
+    std::string value;
+    bool literal = false;
+};
+
+/**
+ * Creates a streaming reader over an already opened stream, the stream must outlive the reader
+ * @param in stream to read
+ * @param format format of the stream, Format::Filesystem is not a stream and it is not supported
+ * @param root receives the name of the root element of an XML document when it is read, it may be null
+ * @return the reader
+ * @throw NotImplemented if the format can not be streamed
+ */
+std::unique_ptr<SettingsReader> createReader(std::istream& in, Settings::Format format, std::string* root = nullptr);
+
+/**
+ * Creates a streaming writer over an already opened stream, the stream must outlive the writer
+ * @param out stream to write
+ * @param format format of the stream, Format::Filesystem is not a stream and it is not supported
+ * @param root name of the root element of an XML document
+ * @return the writer
+ * @throw NotImplemented if the format can not be written
+ */
+std::unique_ptr<SettingsWriter> createWriter(std::ostream& out, Settings::Format format,
+                                             const std::string& root = defaultXmlRoot);
+
+} // namespace project_library
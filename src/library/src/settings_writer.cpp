@@ -0,0 +1,773 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "Poco/File.h"
+#include "Poco/FileStream.h"
+#include "Poco/Path.h"
+#include "settings_file.h"
+#include "settings_stream_impl.h"
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+namespace project_library
+{
+
+namespace
+{
+
+/**
+ * Collects the output of a writer and hands it to the stream in large blocks, so the destination sees a few big writes
+ * instead of one per token. The buffer keeps its capacity from one block to the next.
+ */
+class OutputBuffer
+{
+  public:
+    explicit OutputBuffer(std::ostream& out) : m_out(out)
+    {
+        m_buffer.reserve(BLOCK_SIZE + BLOCK_SIZE / 4);
+    }
+
+    OutputBuffer& operator<<(char c)
+    {
+        m_buffer.push_back(c);
+        return *this;
+    }
+
+    OutputBuffer& operator<<(const char* text)
+    {
+        m_buffer.append(text);
+        return *this;
+    }
+
+    OutputBuffer& operator<<(const std::string& text)
+    {
+        m_buffer.append(text);
+        return *this;
+    }
+
+    /**
+     * Appends a part of a text
+     * @param text
+     * @param pos first character
+     * @param count number of characters
+     */
+    void append(const std::string& text, std::size_t pos, std::size_t count)
+    {
+        m_buffer.append(text, pos, count);
+    }
+
+    /**
+     * Appends a character several times
+     * @param count
+     * @param c
+     */
+    void append(std::size_t count, char c)
+    {
+        m_buffer.append(count, c);
+    }
+
+    /**
+     * Writes the block once it is full, it is called after every record
+     */
+    void commit()
+    {
+        if (m_buffer.size() >= BLOCK_SIZE)
+        {
+            drain();
+        }
+    }
+
+    /**
+     * Writes the pending output and flushes the stream
+     */
+    void flush()
+    {
+        drain();
+        m_out.flush();
+    }
+
+  private:
+    static constexpr std::size_t BLOCK_SIZE = 1 << 20;
+
+    void drain()
+    {
+        m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+
+    std::ostream& m_out;
+    std::string m_buffer;
+};
+
+/**
+ * One step of a key path, 'section.list[2]' is made of the tokens 'section', 'list' and the index '2'
+ */
+struct Token
+{
+    std::string name;
+    bool isIndex = false;
+
+    bool operator==(const Token& other) const
+    {
+        return isIndex == other.isIndex && name == other.name;
+    }
+};
+
+/**
+ * Splits a key in tokens, an attribute suffix '[@name]' is returned apart
+ * @param key
+ * @param tokens path of the key
+ * @param attribute name of the attribute, empty if the key does not address an attribute
+ */
+void tokenize(const std::string& key, std::vector<Token>& tokens, std::string& attribute)
+{
+    tokens.clear();
+    attribute.clear();
+    std::size_t pos = 0;
+    while (pos < key.size())
+    {
+        auto end = pos;
+        while (end < key.size() && key[end] != '.' && key[end] != '[')
+        {
+            ++end;
+        }
+        if (end > pos)
+        {
+            tokens.push_back({key.substr(pos, end - pos), false});
+        }
+        while (end < key.size() && key[end] == '[')
+        {
+            auto close = key.find(']', end);
+            if (close == std::string::npos)
+            {
+                throw SyntaxException("Unbalanced brackets in key '" + key + "'");
+            }
+            if (key[end + 1] == '@')
+            {
+                attribute = key.substr(end + 2, close - end - 2);
+            }
+            else
+            {
+                tokens.push_back({key.substr(end + 1, close - end - 1), true});
+            }
+            end = close + 1;
+        }
+        pos = end < key.size() && key[end] == '.' ? end + 1 : end;
+    }
+}
+
+/**
+ * @return true if value is a JSON number or a boolean literal, so it can be written without quotes
+ */
+bool isJsonLiteral(const std::string& value)
+{
+    if (value == "true" || value == "false")
+    {
+        return true;
+    }
+    std::size_t pos = 0;
+    auto digits = [&value, &pos]() {
+        auto start = pos;
+        while (pos < value.size() && std::isdigit(static_cast<unsigned char>(value[pos])) != 0)
+        {
+            ++pos;
+        }
+        return pos - start;
+    };
+    if (pos < value.size() && value[pos] == '-')
+    {
+        ++pos;
+    }
+    auto integer = digits();
+    if (integer == 0 || (integer > 1 && value[pos - integer] == '0'))
+    {
+        return false;
+    }
+    if (pos < value.size() && value[pos] == '.')
+    {
+        ++pos;
+        if (digits() == 0)
+        {
+            return false;
+        }
+    }
+    if (pos < value.size() && (value[pos] == 'e' || value[pos] == 'E'))
+    {
+        ++pos;
+        if (pos < value.size() && (value[pos] == '+' || value[pos] == '-'))
+        {
+            ++pos;
+        }
+        if (digits() == 0)
+        {
+            return false;
+        }
+    }
+    return pos == value.size();
+}
+
+/**
+ * Writes a JSON document, a section stays open while consecutive keys share its prefix. The keys of a section must be
+ * written together and the items of an array in order from 0. Only the last member of every open section is kept, the
+ * writer throws when a key repeats it or skips an index.
+ */
+class JsonWriter : public SettingsWriter
+{
+  public:
+    explicit JsonWriter(std::ostream& out) : m_out(out)
+    {
+        m_out << '{';
+        m_stack.push_back({{}, '}', false, {}, 0});
+    }
+
+    void write(const std::string& key, const std::string& value) override
+    {
+        writeTyped(key, value, isJsonLiteral(value));
+    }
+
+    void writeTyped(const std::string& key, const std::string& value, bool literal) override
+    {
+        tokenize(key, m_tokens, m_attribute);
+        if (m_tokens.empty() || !m_attribute.empty())
+        {
+            throw SyntaxException("Invalid JSON key '" + key + "'");
+        }
+
+        auto containers = m_tokens.size() - 1;
+        std::size_t common = 0;
+        while (common < containers && common + 1 < m_stack.size() && m_stack[common + 1].token == m_tokens[common])
+        {
+            ++common;
+        }
+        while (m_stack.size() > common + 1)
+        {
+            closeContainer();
+        }
+        for (auto i = common; i < containers; ++i)
+        {
+            writeMember(m_tokens[i], key);
+            auto closer = m_tokens[i + 1].isIndex ? ']' : '}';
+            m_out << (closer == ']' ? '[' : '{');
+            m_stack.push_back({m_tokens[i], closer, false, {}, 0});
+        }
+        writeMember(m_tokens.back(), key);
+        // A number that JSON can not represent, e.g. 'nan', is written as a string
+        if (literal && isJsonLiteral(value))
+        {
+            m_out << value;
+        }
+        else
+        {
+            writeString(value);
+        }
+        m_out.commit();
+    }
+
+    void close() override
+    {
+        while (!m_stack.empty())
+        {
+            closeContainer();
+        }
+        m_out << '\n';
+        m_out.flush();
+    }
+
+  private:
+    struct Frame
+    {
+        Token token;
+        char closer;
+        bool hasItems;
+        /**
+         * Name of the last member of an object, the members of a section are written together so it is the only one
+         * that a key can reopen
+         */
+        std::string lastName;
+        std::size_t items;
+    };
+
+    void indent(std::size_t depth)
+    {
+        m_out << '\n';
+        m_out.append(depth * 2, ' ');
+    }
+
+    void writeMember(const Token& token, const std::string& key)
+    {
+        auto& frame = m_stack.back();
+        if (frame.closer == ']' && !token.isIndex)
+        {
+            throw SyntaxException("Key '" + key + "' mixes an array and an object");
+        }
+        if (frame.closer == ']' && token.name != std::to_string(frame.items))
+        {
+            throw SyntaxException("Key '" + key + "' is out of order, the items of an array must be written from 0");
+        }
+        if (frame.closer == '}' && frame.items > 0 && token.name == frame.lastName)
+        {
+            throw SyntaxException("Key '" + key + "' is written twice or after its section was closed");
+        }
+        if (frame.closer == '}')
+        {
+            frame.lastName = token.name;
+        }
+        ++frame.items;
+        if (frame.hasItems)
+        {
+            m_out << ',';
+        }
+        frame.hasItems = true;
+        indent(m_stack.size());
+        if (frame.closer == '}')
+        {
+            writeString(token.name);
+            m_out << ": ";
+        }
+    }
+
+    void closeContainer()
+    {
+        auto closer = m_stack.back().closer;
+        auto hasItems = m_stack.back().hasItems;
+        m_stack.pop_back();
+        if (hasItems)
+        {
+            indent(m_stack.size());
+        }
+        m_out << closer;
+    }
+
+    void writeString(const std::string& value)
+    {
+        static const char* hex = "0123456789abcdef";
+        m_out << '"';
+        // The runs of characters that need no escaping are copied at once
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < value.size(); ++i)
+        {
+            auto c = value[i];
+            if (c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20)
+            {
+                continue;
+            }
+            m_out.append(value, run, i - run);
+            run = i + 1;
+            switch (c)
+            {
+            case '"':
+                m_out << "\\\"";
+                break;
+            case '\\':
+                m_out << "\\\\";
+                break;
+            case '\b':
+                m_out << "\\b";
+                break;
+            case '\f':
+                m_out << "\\f";
+                break;
+            case '\n':
+                m_out << "\\n";
+                break;
+            case '\r':
+                m_out << "\\r";
+                break;
+            case '\t':
+                m_out << "\\t";
+                break;
+            default:
+                m_out << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+            }
+        }
+        m_out.append(value, run, value.size() - run);
+        m_out << '"';
+    }
+
+    OutputBuffer m_out;
+    std::vector<Frame> m_stack;
+    std::vector<Token> m_tokens;
+    std::string m_attribute;
+};
+
+/**
+ * Writes a XML document with a 'config' root element, the same layout saved by Poco::Util::XMLConfiguration.
+ * Attributes must be written before the content of their element. The keys of an element must be written together and
+ * repeated elements in order from 0. Only the last child of every open element is kept, the writer throws when a key
+ * reopens it or skips an index.
+ */
+class XmlWriter : public SettingsWriter
+{
+  public:
+    XmlWriter(std::ostream& out, const std::string& root) : m_out(out)
+    {
+        m_out << R"(<?xml version="1.0" encoding="UTF-8"?>)" << '\n' << '<' << root;
+        m_stack.push_back({root, 0, true, false, false, {}, -1});
+    }
+
+    void write(const std::string& key, const std::string& value) override
+    {
+        tokenize(key, m_tokens, m_attribute);
+        m_elements.clear();
+        for (const auto& token : m_tokens)
+        {
+            if (token.isIndex)
+            {
+                if (m_elements.empty())
+                {
+                    throw SyntaxException("Invalid XML key '" + key + "'");
+                }
+                m_elements.back().second = std::stoi(token.name);
+            }
+            else
+            {
+                m_elements.emplace_back(token.name, 0);
+            }
+        }
+        if (m_elements.empty() && m_attribute.empty())
+        {
+            throw SyntaxException("Invalid XML key '" + key + "'");
+        }
+
+        std::size_t common = 0;
+        while (common < m_elements.size() && common + 1 < m_stack.size() &&
+               m_stack[common + 1].name == m_elements[common].first &&
+               m_stack[common + 1].index == m_elements[common].second)
+        {
+            ++common;
+        }
+        while (m_stack.size() > common + 1)
+        {
+            closeElement();
+        }
+        for (auto i = common; i < m_elements.size(); ++i)
+        {
+            openElement(m_elements[i].first, m_elements[i].second, key);
+        }
+
+        auto& frame = m_stack.back();
+        if (!m_attribute.empty())
+        {
+            if (!frame.tagOpen)
+            {
+                throw SyntaxException("Attribute '" + key + "' written after the content of its element");
+            }
+            m_out << ' ' << m_attribute << "=\"";
+            escape(value, true);
+            m_out << '"';
+        }
+        else
+        {
+            if (frame.hasText)
+            {
+                throw SyntaxException("Key '" + key + "' is written twice");
+            }
+            if (frame.tagOpen)
+            {
+                m_out << '>';
+                frame.tagOpen = false;
+            }
+            frame.hasText = true;
+            escape(value, false);
+        }
+        m_out.commit();
+    }
+
+    void close() override
+    {
+        while (!m_stack.empty())
+        {
+            closeElement();
+        }
+        m_out << '\n';
+        m_out.flush();
+    }
+
+  private:
+    struct Frame
+    {
+        std::string name;
+        int index;
+        bool tagOpen;
+        bool hasChildren;
+        bool hasText;
+        /**
+         * Name and index of the last child element, the repeated elements are written together and in order
+         */
+        std::string lastName;
+        int lastIndex;
+    };
+
+    void indent()
+    {
+        m_out << '\n';
+        if (m_stack.size() > 1)
+        {
+            m_out.append((m_stack.size() - 1) * 2, ' ');
+        }
+    }
+
+    void openElement(const std::string& name, int index, const std::string& key)
+    {
+        auto& parent = m_stack.back();
+        auto next = name == parent.lastName ? parent.lastIndex + 1 : 0;
+        if (index != next)
+        {
+            throw SyntaxException("Key '" + key +
+                                  "' is out of order, an element can not be reopened and the repeated elements must be "
+                                  "written from 0");
+        }
+        parent.lastName = name;
+        parent.lastIndex = index;
+        if (parent.tagOpen)
+        {
+            m_out << '>';
+            parent.tagOpen = false;
+        }
+        parent.hasChildren = true;
+        indent();
+        m_out << '<' << name;
+        m_stack.push_back({name, index, true, false, false, {}, -1});
+    }
+
+    void closeElement()
+    {
+        auto frame = std::move(m_stack.back());
+        m_stack.pop_back();
+        if (frame.tagOpen)
+        {
+            m_out << "/>";
+            return;
+        }
+        if (frame.hasChildren && !frame.hasText)
+        {
+            indent();
+        }
+        m_out << "</" << frame.name << '>';
+    }
+
+    void escape(const std::string& value, bool attribute)
+    {
+        // The runs of characters that need no escaping are copied at once
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < value.size(); ++i)
+        {
+            auto c = value[i];
+            if (c != '&' && c != '<' && c != '>' && (c != '"' || !attribute))
+            {
+                continue;
+            }
+            m_out.append(value, run, i - run);
+            run = i + 1;
+            switch (c)
+            {
+            case '&':
+                m_out << "&amp;";
+                break;
+            case '<':
+                m_out << "&lt;";
+                break;
+            case '>':
+                m_out << "&gt;";
+                break;
+            default:
+                m_out << "&quot;";
+            }
+        }
+        m_out.append(value, run, value.size() - run);
+    }
+
+    OutputBuffer m_out;
+    std::vector<Frame> m_stack;
+    std::vector<Token> m_tokens;
+    std::vector<std::pair<std::string, int>> m_elements;
+    std::string m_attribute;
+};
+
+/**
+ * Writes 'key: value' lines with the escape sequences understood by Poco::Util::PropertyFileConfiguration. The keys are
+ * escaped as well, so that separators, spaces and a leading comment mark read back as part of the key.
+ */
+class PropertyFileWriter : public SettingsWriter
+{
+  public:
+    explicit PropertyFileWriter(std::ostream& out) : m_out(out)
+    {
+    }
+
+    void write(const std::string& key, const std::string& value) override
+    {
+        escape(key, true);
+        m_out << ": ";
+        escape(value, false);
+        m_out << '\n';
+        m_out.commit();
+    }
+
+    void close() override
+    {
+        m_out.flush();
+    }
+
+  private:
+    /**
+     * @param text
+     * @param key the separators, the spaces and a leading comment mark are escaped too, so the key reads back whole
+     */
+    void escape(const std::string& text, bool key)
+    {
+        // The runs of characters that need no escaping are copied at once
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            auto c = text[i];
+            bool special = c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\\';
+            bool separator = c == ':' || c == '=' || c == ' ' || (i == 0 && (c == '#' || c == '!'));
+            if (!special && !(key && separator))
+            {
+                continue;
+            }
+            m_out.append(text, run, i - run);
+            run = i + 1;
+            switch (c)
+            {
+            case '\t':
+                m_out << "\\t";
+                break;
+            case '\r':
+                m_out << "\\r";
+                break;
+            case '\n':
+                m_out << "\\n";
+                break;
+            case '\f':
+                m_out << "\\f";
+                break;
+            case '\\':
+                m_out << "\\\\";
+                break;
+            default:
+                m_out << '\\' << c;
+            }
+        }
+        m_out.append(text, run, text.size() - run);
+    }
+
+    OutputBuffer m_out;
+};
+
+/**
+ * Creates the folder tree used by Poco::Util::FilesystemConfiguration
+ */
+class FilesystemWriter : public SettingsWriter
+{
+  public:
+    explicit FilesystemWriter(const std::string& root) : m_root(Poco::Path(root).makeDirectory())
+    {
+    }
+
+    void write(const std::string& key, const std::string& value) override
+    {
+        Poco::Path path(m_root);
+        std::size_t pos = 0;
+        while (pos <= key.size())
+        {
+            auto end = std::min(key.find('.', pos), key.size());
+            path.pushDirectory(key.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        Poco::File(path).createDirectories();
+        path.setFileName("data");
+        Poco::FileOutputStream ostr(path.toString());
+        ostr << value;
+    }
+
+    void close() override
+    {
+    }
+
+  private:
+    Poco::Path m_root;
+};
+
+/**
+ * Keeps the file opened by openWriter() alive as long as the writer, paths ending in '.gz' are gzip compressed
+ */
+class FileWriter : public SettingsWriter
+{
+  public:
+    FileWriter(const std::string& path, Settings::Format format)
+        : m_file(path, SettingsOutputFile::hasCompressedSuffix(path)), m_writer(createWriter(m_file.stream(), format))
+    {
+    }
+
+    void write(const std::string& key, const std::string& value) override
+    {
+        m_writer->write(key, value);
+    }
+
+    void writeTyped(const std::string& key, const std::string& value, bool literal) override
+    {
+        m_writer->writeTyped(key, value, literal);
+    }
+
+    void close() override
+    {
+        m_writer->close();
+        m_file.close();
+    }
+
+  private:
+    SettingsOutputFile m_file;
+    std::unique_ptr<SettingsWriter> m_writer;
+};
+
+/**
+ * @throw NotImplemented if the format can not be written as a stream
+ */
+void checkWritable(Settings::Format format)
+{
+    switch (format)
+    {
+    case Settings::Format::JSON:
+    case Settings::Format::XML:
+    case Settings::Format::PropertyFile:
+        break;
+    case Settings::Format::IniFile:
+        throw NotImplemented("The legacy Windows initialization (.ini) files are read only");
+    default:
+        throw NotImplemented("This settings format is not stored in a stream");
+    }
+}
+
+} // namespace
+
+std::unique_ptr<SettingsWriter> createWriter(std::ostream& out, Settings::Format format, const std::string& root)
+{
+    checkWritable(format);
+    switch (format)
+    {
+    case Settings::Format::JSON:
+        return std::make_unique<JsonWriter>(out);
+    case Settings::Format::XML:
+        return std::make_unique<XmlWriter>(out, root);
+    default:
+        return std::make_unique<PropertyFileWriter>(out);
+    }
+}
+
+std::unique_ptr<SettingsWriter> openWriter(const std::string& path, Settings::Format format)
+{
+    if (format == Settings::Format::Filesystem)
+    {
+        return std::make_unique<FilesystemWriter>(path);
+    }
+    checkWritable(format);
+    return std::make_unique<FileWriter>(path, format);
+}
+
+} // namespace project_library
@@ -0,0 +1,233 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "sharded_configuration.h"
+#include "flat_configuration.h"
+#include "settings_stream_impl.h"
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+namespace project_library
+{
+
+ShardedConfiguration::ShardedConfiguration(Settings::Format format) : m_format(format), m_root(defaultXmlRoot)
+{
+}
+
+std::size_t ShardedConfiguration::shardIndex(const std::string& key)
+{
+    return std::hash<std::string>{}(key) % shardCount;
+}
+
+ShardedConfiguration::Shard& ShardedConfiguration::shard(const std::string& key)
+{
+    return m_shards[shardIndex(key)];
+}
+
+const ShardedConfiguration::Shard& ShardedConfiguration::shard(const std::string& key) const
+{
+    return m_shards[shardIndex(key)];
+}
+
+bool ShardedConfiguration::fetch(const std::string& key, std::string& value) const
+{
+    auto normalized = FlatConfiguration::normalize(key, m_format);
+    const auto& target = shard(normalized);
+    std::lock_guard<std::mutex> lock(target.mutex);
+    auto it = target.values.find(normalized);
+    if (it == target.values.end())
+    {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+void ShardedConfiguration::put(const std::string& key, std::string value, bool literal)
+{
+    auto normalized = FlatConfiguration::normalize(key, m_format);
+    auto& target = shard(normalized);
+    std::lock_guard<std::mutex> lock(target.mutex);
+    if (literal && m_format == Settings::Format::JSON)
+    {
+        target.literals.insert(normalized);
+    }
+    else
+    {
+        target.literals.erase(normalized);
+    }
+    target.values.insert_or_assign(std::move(normalized), std::move(value));
+}
+
+void ShardedConfiguration::update(const std::string& key, std::string value)
+{
+    auto normalized = FlatConfiguration::normalize(key, m_format);
+    auto& target = shard(normalized);
+    std::lock_guard<std::mutex> lock(target.mutex);
+    target.values.insert_or_assign(std::move(normalized), std::move(value));
+}
+
+ShardedConfiguration::Records ShardedConfiguration::snapshot() const
+{
+    Records records;
+    {
+        // The shards are always locked in the same order, no writer can change a shard already copied
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(shardCount);
+        std::size_t size = 0;
+        for (const auto& current : m_shards)
+        {
+            locks.emplace_back(current.mutex);
+            size += current.values.size();
+        }
+        records.reserve(size);
+        for (const auto& current : m_shards)
+        {
+            for (const auto& [key, value] : current.values)
+            {
+                records.push_back({key, value, current.literals.count(key) != 0});
+            }
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const auto& left, const auto& right) {
+        return FlatConfiguration::naturalLess(left.key, right.key);
+    });
+    return records;
+}
+
+void ShardedConfiguration::load(std::istream& input)
+{
+    std::array<Values, shardCount> values;
+    std::array<Literals, shardCount> literals;
+    std::string root = defaultXmlRoot;
+    createReader(input, m_format, &root)
+        ->readTyped([this, &values, &literals](const std::string& key, const std::string& value, bool literal) {
+            auto normalized = FlatConfiguration::normalize(key, m_format);
+            auto index = shardIndex(normalized);
+            if (literal)
+            {
+                literals[index].insert(normalized);
+            }
+            else
+            {
+                literals[index].erase(normalized);
+            }
+            values[index].insert_or_assign(std::move(normalized), value);
+        });
+    swapIn(values, literals);
+    setRoot(root);
+}
+
+void ShardedConfiguration::replace(Records records)
+{
+    std::array<Values, shardCount> values;
+    std::array<Literals, shardCount> literals;
+    for (auto& record : records)
+    {
+        auto normalized = FlatConfiguration::normalize(record.key, m_format);
+        auto index = shardIndex(normalized);
+        if (record.literal)
+        {
+            literals[index].insert(normalized);
+        }
+        values[index].insert_or_assign(std::move(normalized), std::move(record.value));
+    }
+    records.clear();
+    swapIn(values, literals);
+}
+
+void ShardedConfiguration::swapIn(std::array<Values, shardCount>& values, std::array<Literals, shardCount>& literals)
+{
+    for (std::size_t i = 0; i < shardCount; ++i)
+    {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        m_shards[i].values.swap(values[i]);
+        m_shards[i].literals.swap(literals[i]);
+    }
+}
+
+void ShardedConfiguration::save(std::ostream& output) const
+{
+    auto records = snapshot();
+    auto writer = createWriter(output, m_format, root());
+    for (const auto& record : records)
+    {
+        writer->writeTyped(record.key, record.value, record.literal);
+    }
+    writer->close();
+}
+
+std::string ShardedConfiguration::root() const
+{
+    Poco::Mutex::ScopedLock lock(_mutex);
+    return m_root;
+}
+
+void ShardedConfiguration::setRoot(const std::string& root)
+{
+    Poco::Mutex::ScopedLock lock(_mutex);
+    m_root = root;
+}
+
+bool ShardedConfiguration::getRaw(const std::string& key, std::string& value) const
+{
+    return fetch(key, value);
+}
+
+void ShardedConfiguration::setRaw(const std::string& key, const std::string& value)
+{
+    put(key, value);
+}
+
+void ShardedConfiguration::enumerate(const std::string& key, Keys& range) const
+{
+    auto prefix = key.empty() ? key : FlatConfiguration::normalize(key, m_format) + '.';
+    std::unordered_set<std::string> seen;
+    for (const auto& current : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(current.mutex);
+        for (const auto& [name, value] : current.values)
+        {
+            if (name.compare(0, prefix.size(), prefix) != 0)
+            {
+                continue;
+            }
+            auto child = name.substr(prefix.size(), name.find('.', prefix.size()) - prefix.size());
+            if (seen.insert(child).second)
+            {
+                range.push_back(std::move(child));
+            }
+        }
+    }
+}
+
+void ShardedConfiguration::removeRaw(const std::string& key)
+{
+    auto normalized = FlatConfiguration::normalize(key, m_format);
+    auto child = normalized + '.';
+    auto attribute = normalized + "[@";
+    for (auto& current : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(current.mutex);
+        for (auto it = current.values.begin(); it != current.values.end();)
+        {
+            const auto& name = it->first;
+            if (name == normalized || name.compare(0, child.size(), child) == 0 ||
+                name.compare(0, attribute.size(), attribute) == 0)
+            {
+                current.literals.erase(name);
+                it = current.values.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
+
+} // namespace project_library
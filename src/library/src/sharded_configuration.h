@@ -0,0 +1,144 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/Util/AbstractConfiguration.h"
+#include "settings.h"
+#include "settings_stream_impl.h"
+#include <array>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace project_library
+{
+
+/**
+ * Flat key/value store for settings written from many threads. The keys are spread by their hash over independently
+ * locked shards, so the writers of different keys rarely wait for each other. The inherited getters and setters still
+ * go through the configuration mutex, fetch() and put() are the entry points for the hot paths that only lock one
+ * shard. Only the keys that hold a value exist, a section is not a key of its own.
+ */
+class ShardedConfiguration : public Poco::Util::AbstractConfiguration
+{
+  public:
+    using Records = std::vector<TypedRecord>;
+
+    /**
+     * Constructor
+     * @param format format of the document
+     */
+    explicit ShardedConfiguration(Settings::Format format);
+
+    /**
+     * Reads a raw value, only the shard of the key is locked
+     * @param key
+     * @param value receives the value
+     * @return true if the key exists
+     */
+    bool fetch(const std::string& key, std::string& value) const;
+
+    /**
+     * Writes a raw value, only the shard of the key is locked
+     * @param key
+     * @param value
+     * @param literal true if a JSON document holds the value as a number or a boolean
+     */
+    void put(const std::string& key, std::string value, bool literal = false);
+
+    /**
+     * Writes a raw value and keeps its type, a new key holds a string. Only the shard of the key is locked
+     * @param key
+     * @param value
+     */
+    void update(const std::string& key, std::string value);
+
+    /**
+     * Copies every value at a single point in time, all the shards are locked while they are copied
+     * @return the records sorted in the natural order of the format
+     */
+    Records snapshot() const;
+
+    /**
+     * Replaces the values with the content of a document, the name of the root element of an XML document is kept
+     * for save(). The new shards are built first and each one is swapped in under its own lock, a concurrent reader
+     * finds either the previous or the new value of a key.
+     * @param input document
+     * @throw SyntaxException if the document is malformed
+     */
+    void load(std::istream& input);
+
+    /**
+     * Writes a snapshot of the values as a document
+     * @param output destination
+     */
+    void save(std::ostream& output) const;
+
+    /**
+     * @return the name of the root element of the XML document, 'config' until a document is loaded
+     */
+    std::string root() const;
+
+    /**
+     * @param root name of the root element written by save()
+     */
+    void setRoot(const std::string& root);
+
+    /**
+     * Replaces the values with records, see load()
+     * @param records keys and raw values
+     */
+    void replace(Records records);
+
+  protected:
+    bool getRaw(const std::string& key, std::string& value) const override;
+    void setRaw(const std::string& key, const std::string& value) override;
+    void enumerate(const std::string& key, Keys& range) const override;
+    void removeRaw(const std::string& key) override;
+
+    ~ShardedConfiguration() override = default;
+
+  private:
+    /**
+     * Every shard on its own cache line, so the writers of neighbour shards do not invalidate each other
+     */
+    using Values = std::unordered_map<std::string, std::string>;
+    using Literals = std::unordered_set<std::string>;
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        Values values;
+
+        /**
+         * Keys of the values that a JSON document holds as numbers or booleans
+         */
+        Literals literals;
+    };
+
+    static constexpr std::size_t shardCount = 64;
+
+    static std::size_t shardIndex(const std::string& key);
+    Shard& shard(const std::string& key);
+    const Shard& shard(const std::string& key) const;
+
+    /**
+     * Swaps every new shard in, the previous values are released after the locks
+     * @param values the new values of every shard, they receive the previous ones
+     * @param literals the new literal keys of every shard, they receive the previous ones
+     */
+    void swapIn(std::array<Values, shardCount>& values, std::array<Literals, shardCount>& literals);
+
+    Settings::Format m_format;
+    std::string m_root;
+    std::array<Shard, shardCount> m_shards;
+};
+
+} // namespace project_library
@@ -0,0 +1,248 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "trace.h"
+#include "Poco/Process.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace project_library
+{
+
+namespace
+{
+
+/**
+ * Keeps the events in memory and writes them in batches, so recording adds little I/O to the traced phases and the
+ * memory of a long running process stays bounded
+ */
+class TraceRecorder
+{
+  public:
+    static TraceRecorder& instance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    bool enabled() const
+    {
+        return !m_path.empty();
+    }
+
+    std::int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_origin)
+            .count();
+    }
+
+    void add(const char* name, const char* category, char phase, std::int64_t start, std::int64_t duration)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.push_back({name, category, phase, start, duration, threadId()});
+        if (m_events.size() >= MAX_BUFFERED_EVENTS)
+        {
+            writePending();
+        }
+    }
+
+    void nameThread(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threadNames[threadId()] = name;
+    }
+
+    /**
+     * Writes the pending events and completes the document, the events recorded later are written before the end
+     */
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_path.empty())
+        {
+            return;
+        }
+        writePending();
+        m_out << "\n]}\n";
+        m_out.flush();
+        m_out.seekp(m_end);
+    }
+
+    ~TraceRecorder()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+            // Nothing can be reported while the process exits
+        }
+    }
+
+  private:
+    static constexpr std::size_t MAX_BUFFERED_EVENTS = 1 << 16;
+
+    struct Event
+    {
+        const char* name;
+        const char* category;
+        char phase;
+        std::int64_t start;
+        std::int64_t duration;
+        unsigned tid;
+    };
+
+    TraceRecorder() : m_origin(std::chrono::steady_clock::now())
+    {
+        const char* path = std::getenv(TRACE_ENVIRONMENT_VARIABLE);
+        if (path != nullptr)
+        {
+            m_path = path;
+        }
+    }
+
+    /**
+     * Appends the pending thread names and events to the trace file, the caller holds the mutex
+     */
+    void writePending()
+    {
+        if (!m_out.is_open())
+        {
+            m_out.open(m_path, std::ios::binary | std::ios::trunc);
+            m_out << R"({"displayTimeUnit":"ms","traceEvents":[)";
+            m_end = m_out.tellp();
+        }
+        auto pid = Poco::Process::id();
+        for (const auto& [tid, name] : m_threadNames)
+        {
+            m_out << m_separator << R"({"name":"thread_name","ph":"M","pid":)" << pid << R"(,"tid":)" << tid
+                  << R"(,"args":{"name":")" << name << R"("}})";
+            m_separator = ",\n";
+        }
+        m_threadNames.clear();
+        for (const auto& event : m_events)
+        {
+            m_out << m_separator << R"({"name":")" << event.name << R"(","cat":")" << event.category
+                  << R"(","ph":")" << event.phase << R"(","ts":)" << event.start << R"(,"pid":)" << pid << R"(,"tid":)"
+                  << event.tid;
+            if (event.phase == 'X')
+            {
+                m_out << R"(,"dur":)" << event.duration;
+            }
+            else
+            {
+                m_out << R"(,"s":"t")";
+            }
+            m_out << '}';
+            m_separator = ",\n";
+        }
+        m_events.clear();
+        m_end = m_out.tellp();
+    }
+
+    /**
+     * @return a small sequential number for the calling thread, the caller holds the mutex
+     */
+    unsigned threadId()
+    {
+        auto it = m_threads.find(std::this_thread::get_id());
+        if (it == m_threads.end())
+        {
+            it = m_threads.emplace(std::this_thread::get_id(), static_cast<unsigned>(m_threads.size() + 1)).first;
+        }
+        return it->second;
+    }
+
+    std::chrono::steady_clock::time_point m_origin;
+    std::string m_path;
+    std::mutex m_mutex;
+    std::vector<Event> m_events;
+    std::map<std::thread::id, unsigned> m_threads;
+    std::map<unsigned, std::string> m_threadNames;
+    std::ofstream m_out;
+    std::ofstream::pos_type m_end;
+    const char* m_separator = "\n";
+};
+
+} // namespace
+
+TraceSpan::TraceSpan(const char* name, const char* category) noexcept
+    : m_name(name), m_category(category), m_start(traceEnabled() ? TraceRecorder::instance().now() : -1)
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_start < 0)
+    {
+        return;
+    }
+    auto& recorder = TraceRecorder::instance();
+    try
+    {
+        recorder.add(m_name, m_category, 'X', m_start, recorder.now() - m_start);
+    }
+    catch (...)
+    {
+        // A lost event is not worth an exception
+    }
+}
+
+bool traceEnabled() noexcept
+{
+    static const bool enabled = TraceRecorder::instance().enabled();
+    return enabled;
+}
+
+void traceInstant(const char* name, const char* category) noexcept
+{
+    if (!traceEnabled())
+    {
+        return;
+    }
+    auto& recorder = TraceRecorder::instance();
+    try
+    {
+        recorder.add(name, category, 'i', recorder.now(), 0);
+    }
+    catch (...)
+    {
+        // A lost event is not worth an exception
+    }
+}
+
+void traceThreadName(const char* name) noexcept
+{
+    if (!traceEnabled())
+    {
+        return;
+    }
+    try
+    {
+        TraceRecorder::instance().nameThread(name);
+    }
+    catch (...)
+    {
+        // A lost event is not worth an exception
+    }
+}
+
+void traceFlush()
+{
+    if (traceEnabled())
+    {
+        TraceRecorder::instance().flush();
+    }
+}
+
+} // namespace project_library
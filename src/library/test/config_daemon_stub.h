@@ -0,0 +1,227 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#pragma once
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPRequestHandlerFactory.h"
+#include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/ServerSocket.h"
+#include "Poco/StreamCopier.h"
+#include "Poco/URI.h"
+#include "settings_patch.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * In-process configuration daemon for the tests and the benchmarks, it listens on a free port of the loopback interface
+ * and serves the documents stored in memory.
+ */
+class ConfigDaemonStub
+{
+  public:
+    ConfigDaemonStub()
+        : m_server(new Factory(*this), Poco::Net::ServerSocket(Poco::Net::SocketAddress("127.0.0.1", 0)),
+                   new Poco::Net::HTTPServerParams)
+    {
+        m_server.start();
+    }
+
+    ~ConfigDaemonStub()
+    {
+        m_server.stopAll(true);
+    }
+
+    /**
+     * @return the address to set in CONFIG_DAEMON_ENVIRONMENT_VARIABLE
+     */
+    std::string address() const
+    {
+        return "127.0.0.1:" + std::to_string(m_server.port());
+    }
+
+    /**
+     * Changes a value of a document as another client would do
+     */
+    void set(const std::string& name, const std::string& key, const std::string& value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& document = m_documents[name];
+        document.values[key] = value;
+        ++document.version;
+    }
+
+    std::string get(const std::string& name, const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_documents.at(name).values.at(key);
+    }
+
+    /**
+     * Makes the daemon hang: every request waits and is then dropped without an answer
+     * @param delay time each request waits, zero serves the requests again
+     */
+    void stall(std::chrono::milliseconds delay)
+    {
+        m_stall = static_cast<int>(delay.count());
+    }
+
+    /**
+     * @return number of requests served
+     */
+    int requests() const
+    {
+        return m_requests;
+    }
+
+    /**
+     * @return number of requests answered with 304 Not Modified
+     */
+    int notModified() const
+    {
+        return m_notModified;
+    }
+
+  private:
+    struct Document
+    {
+        std::map<std::string, std::string> values;
+        unsigned version = 1;
+    };
+
+    class Handler : public Poco::Net::HTTPRequestHandler
+    {
+      public:
+        explicit Handler(ConfigDaemonStub& owner) : m_owner(owner)
+        {
+        }
+
+        void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) override
+        {
+            if (m_owner.m_stall > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_owner.m_stall));
+                return;
+            }
+            ++m_owner.m_requests;
+            const std::string prefix = "/settings/";
+            std::string name;
+            Poco::URI::decode(request.getURI().substr(prefix.size()), name);
+            std::string body;
+            Poco::StreamCopier::copyToString(request.stream(), body);
+
+            std::lock_guard<std::mutex> lock(m_owner.m_mutex);
+            auto document = m_owner.m_documents.find(name);
+            if (request.getMethod() == Poco::Net::HTTPRequest::HTTP_PATCH)
+            {
+                auto patch = project_library::SettingsPatch::parse(body);
+                auto& patched = m_owner.m_documents[name];
+                auto& values = patched.values;
+                for (const auto& [key, value] : patch.added)
+                {
+                    values[key] = value;
+                }
+                for (const auto& [key, value] : patch.changed)
+                {
+                    values[key] = value;
+                }
+                for (const auto& key : patch.removed)
+                {
+                    values.erase(key);
+                }
+                response.set("X-Previous-ETag", etag(patched.version));
+                response.set("ETag", etag(++patched.version));
+                response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NO_CONTENT);
+                response.send();
+                return;
+            }
+            if (document == m_owner.m_documents.end())
+            {
+                response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+                response.send();
+                return;
+            }
+            response.set("ETag", etag(document->second.version));
+            if (request.get("If-None-Match", "") == etag(document->second.version))
+            {
+                ++m_owner.m_notModified;
+                response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+                response.send();
+                return;
+            }
+            std::string properties;
+            for (const auto& [key, value] : document->second.values)
+            {
+                properties += key + ": " + escape(value) + '\n';
+            }
+            response.setContentType("text/plain");
+            response.setContentLength(static_cast<std::streamsize>(properties.size()));
+            response.send() << properties;
+        }
+
+      private:
+        static std::string etag(unsigned version)
+        {
+            return '"' + std::to_string(version) + '"';
+        }
+
+        static std::string escape(const std::string& value)
+        {
+            std::string escaped;
+            for (auto c : value)
+            {
+                switch (c)
+                {
+                case '\\':
+                    escaped += "\\\\";
+                    break;
+                case '\t':
+                    escaped += "\\t";
+                    break;
+                case '\r':
+                    escaped += "\\r";
+                    break;
+                case '\n':
+                    escaped += "\\n";
+                    break;
+                default:
+                    escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        ConfigDaemonStub& m_owner;
+    };
+
+    class Factory : public Poco::Net::HTTPRequestHandlerFactory
+    {
+      public:
+        explicit Factory(ConfigDaemonStub& owner) : m_owner(owner)
+        {
+        }
+
+        Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&) override
+        {
+            return new Handler(m_owner);
+        }
+
+      private:
+        ConfigDaemonStub& m_owner;
+    };
+
+    std::mutex m_mutex;
+    std::map<std::string, Document> m_documents;
+    std::atomic<int> m_requests{0};
+    std::atomic<int> m_notModified{0};
+    std::atomic<int> m_stall{0};
+    Poco::Net::HTTPServer m_server;
+};
@@ -5,7 +5,18 @@
  */
 
 #include "settings.h"
+#include "settings_schema.h"
+#include "settings_stream.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <map>
+#include <thread>
+#include <vector>
 
 using namespace project_library;
 
@@ -89,6 +100,62 @@ TEST(Settings, XML_load)
     EXPECT_EQ(settings.getBool("section.value4"), false);
 }
 
+TEST(Settings, XML_structure)
+{
+    {
+        std::ofstream file("appdata/structure.xml");
+        file << R"(<config><server port="8080"><name>first</name></server><server><name>second</name></server>)"
+             << "<list><item>1</item><item>2</item><item>3</item><item>4</item><item>5</item><item>6</item>"
+             << "<item>7</item><item>8</item><item>9</item><item>10</item><item>11</item></list></config>";
+    }
+    Settings settings("structure.xml", "appdata", false, Settings::Format::XML);
+    settings.load();
+    EXPECT_EQ(settings.getInt("server[@port]"), 8080);
+    EXPECT_EQ(settings.getString("server.name"), "first");
+    EXPECT_EQ(settings.getString("server[0].name"), "first");
+    EXPECT_EQ(settings.getString("server[1].name"), "second");
+    EXPECT_EQ(settings.getInt("list.item[10]"), 11);
+    EXPECT_TRUE(settings.exists("server"));
+
+    settings.setString("server[1][@port]", "8081");
+    settings.save();
+    std::map<std::string, std::string> saved;
+    openReader("appdata/structure.xml", Settings::Format::XML)
+        ->read([&saved](const std::string& key, const std::string& value) { saved[key] = value; });
+    EXPECT_EQ(saved["server[@port]"], "8080");
+    EXPECT_EQ(saved["server[1][@port]"], "8081");
+    EXPECT_EQ(saved["server[1].name"], "second");
+    EXPECT_EQ(saved["list.item[10]"], "11");
+}
+
+TEST(Settings, XML_root)
+{
+    std::filesystem::remove("appdata/root.xml.cache");
+    {
+        std::ofstream file("appdata/root.xml");
+        file << R"(<?xml version="1.0"?><!-- comment --><application><value>1</value></application>)";
+    }
+    {
+        Settings settings("root.xml", "appdata", false, Settings::Format::XML);
+        settings.load();
+    }
+    // The second load replays the pre-parsed copy, it keeps the root name as well
+    auto before = Settings::cacheStatistics();
+    {
+        Settings settings("root.xml", "appdata", false, Settings::Format::XML);
+        settings.load();
+        EXPECT_EQ(settings.getInt("value"), 1);
+        settings.setInt("value", 2);
+        settings.save();
+    }
+    EXPECT_EQ(Settings::cacheStatistics().hits - before.hits, 1U);
+    std::ifstream file("appdata/root.xml");
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find("<application>"), std::string::npos);
+    EXPECT_EQ(content.find("<config"), std::string::npos);
+    EXPECT_EQ(content.substr(content.size() - 15), "</application>\n");
+}
+
 TEST(Settings, PropertyFile_save)
 {
     Settings settings("settings.prop", "appdata", false, Settings::Format::PropertyFile);
@@ -130,3 +197,461 @@ TEST(Settings, WinRegistry_load)
     EXPECT_EQ(settings.getBool("value4"), false);
 }
 #endif
+
+TEST(Settings, Overlay)
+{
+    Settings parent("overlay.json", "appdata", false, Settings::Format::JSON);
+    parent.setString("section.value1", "string");
+    parent.setInt("section.value2", 123);
+    parent.setString("section.value3", "${section.value1}-suffix");
+
+    auto child = parent.overlay();
+    child->setString("section.value1", "override");
+    child->setBool("section.value4", true);
+
+    EXPECT_EQ(child->getString("section.value1"), "override");
+    EXPECT_EQ(child->getInt("section.value2"), 123);
+    EXPECT_EQ(child->getString("section.value3"), "override-suffix");
+    EXPECT_EQ(child->getBool("section.value4"), true);
+
+    EXPECT_EQ(parent.getString("section.value1"), "string");
+    EXPECT_EQ(parent.getString("section.value3"), "string-suffix");
+    EXPECT_FALSE(parent.exists("section.value4"));
+
+    parent.setInt("section.value2", 321);
+    EXPECT_EQ(child->getInt("section.value2"), 321);
+
+    EXPECT_THROW(child->save(), NotImplemented);
+    EXPECT_THROW(child->load(), NotImplemented);
+}
+
+TEST(Settings, Compressed_save)
+{
+    Settings settings("settings.json.gz", "appdata", false, Settings::Format::JSON);
+    settings.setString("section.value1", "string");
+    settings.setInt("section.value2", 123);
+    settings.save();
+
+    std::ifstream file("appdata/settings.json.gz", std::ios::binary);
+    EXPECT_EQ(file.get(), 0x1f);
+    EXPECT_EQ(file.get(), 0x8b);
+}
+
+TEST(Settings, Compressed_load)
+{
+    Settings settings("settings.json.gz", "appdata", false, Settings::Format::JSON);
+    settings.load();
+    EXPECT_EQ(settings.getString("section.value1"), "string");
+    EXPECT_EQ(settings.getInt("section.value2"), 123);
+}
+
+TEST(Settings, Shared_store)
+{
+    Settings first("shared.json", "appdata", false, Settings::Format::JSON);
+    first.setString("section.value1", "string");
+    first.save();
+
+    Settings second("shared.json", "appdata", false, Settings::Format::JSON);
+    second.load();
+    EXPECT_EQ(second.getString("section.value1"), "string");
+
+    first.setInt("section.value2", 123);
+    EXPECT_EQ(second.getInt("section.value2"), 123);
+}
+
+TEST(Settings, Load_discards_unsaved_values)
+{
+    Settings settings("unsaved.json", "appdata", false, Settings::Format::JSON);
+    settings.setString("section.value1", "saved");
+    settings.save();
+    settings.load();
+    EXPECT_EQ(settings.getString("section.value1"), "saved");
+
+    // The file did not change, the edit alone makes load() parse it again
+    settings.setString("section.value1", "edited");
+    settings.setInt("section.value2", 123);
+    settings.load();
+    EXPECT_EQ(settings.getString("section.value1"), "saved");
+    EXPECT_FALSE(settings.exists("section.value2"));
+}
+
+TEST(Settings, Deferred_folders)
+{
+    std::filesystem::remove_all("appdata/deferred");
+    Settings settings("settings.json", "appdata/deferred", false, Settings::Format::JSON);
+    settings.setString("section.value1", "string");
+    EXPECT_FALSE(std::filesystem::exists("appdata/deferred"));
+    settings.save();
+    EXPECT_TRUE(std::filesystem::exists("appdata/deferred/settings.json"));
+}
+
+TEST(Settings, Schema_violations)
+{
+    Settings source("schema.json", "appdata", false, Settings::Format::JSON);
+    source.setString("section.value1", "fast");
+    source.setString("section.value2", "abc");
+    source.setInt("section.value3", 150);
+    source.save();
+
+    SettingsSchema schema;
+    schema.define("section.value1", SettingsSchema::Type::String).allowed = {"slow", "normal"};
+    schema.define("section.value2", SettingsSchema::Type::Int);
+    auto& range = schema.define("section.value3", SettingsSchema::Type::Int);
+    range.minimum = 0;
+    range.maximum = 100;
+    schema.define("section.value4", SettingsSchema::Type::Bool, true);
+
+    Settings settings("schema.json", "appdata", false, Settings::Format::JSON);
+    settings.setSchema(schema);
+    try
+    {
+        settings.load();
+        FAIL() << "the schema was not checked";
+    }
+    catch (ValidationException& e)
+    {
+        EXPECT_EQ(e.violations().size(), 4U);
+    }
+}
+
+TEST(Settings, Schema_resolved_values)
+{
+    Settings settings("schema_resolved.json", "appdata", false, Settings::Format::JSON);
+    settings.setString("section.value1", "0x10");
+    settings.setString("section.value2", "yes");
+    settings.setDouble("section.value3", 321.5);
+    settings.save();
+
+    SettingsSchema schema;
+    schema.define("section.value1", SettingsSchema::Type::Int, true);
+    schema.define("section.value2", SettingsSchema::Type::Bool, true);
+    schema.define("section.value3", SettingsSchema::Type::Double, true);
+    settings.setSchema(schema);
+    settings.load();
+    EXPECT_EQ(settings.getInt("section.value1"), 16);
+    EXPECT_EQ(settings.getBool("section.value2"), true);
+    EXPECT_EQ(settings.getDouble("section.value3"), 321.5);
+    EXPECT_EQ(settings.getString("section.value1"), "0x10");
+
+    // A setter replaces the converted value
+    settings.setInt("section.value1", 5);
+    EXPECT_EQ(settings.getInt("section.value1"), 5);
+}
+
+TEST(Settings, Schema_range_of_numbers)
+{
+    Settings settings("schema_range.json", "appdata", false, Settings::Format::JSON);
+    settings.setString("section.value1", "string");
+    settings.setBool("section.value2", true);
+    settings.setInt("section.value3", 5);
+    settings.save();
+
+    // A range on a string or a boolean is ignored
+    SettingsSchema schema;
+    for (const auto& [key, type] : {std::make_pair("section.value1", SettingsSchema::Type::String),
+                                    std::make_pair("section.value2", SettingsSchema::Type::Bool),
+                                    std::make_pair("section.value3", SettingsSchema::Type::Int)})
+    {
+        auto& rule = schema.define(key, type, true);
+        rule.minimum = 1;
+        rule.maximum = 10;
+    }
+    settings.setSchema(schema);
+    EXPECT_NO_THROW(settings.load());
+}
+
+TEST(Settings, Parse_cache)
+{
+    std::filesystem::remove("appdata/parse_cache.json.cache");
+    {
+        Settings settings("parse_cache.json", "appdata", false, Settings::Format::JSON);
+        settings.setString("section.value1", "string");
+        settings.setInt("section.value2", 123);
+        settings.setBool("section.list[0]", true);
+        settings.save();
+    }
+    auto before = Settings::cacheStatistics();
+    {
+        Settings settings("parse_cache.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+    }
+    EXPECT_TRUE(std::filesystem::exists("appdata/parse_cache.json.cache"));
+    {
+        Settings settings("parse_cache.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+        EXPECT_EQ(settings.getInt("section.value2"), 123);
+        EXPECT_EQ(settings.getBool("section.list[0]"), true);
+    }
+    auto after = Settings::cacheStatistics();
+    EXPECT_EQ(after.misses - before.misses, 1U);
+    EXPECT_EQ(after.hits - before.hits, 1U);
+}
+
+TEST(Settings, Parse_cache_damaged)
+{
+    std::filesystem::remove("appdata/parse_cache_damaged.json.cache");
+    {
+        Settings settings("parse_cache_damaged.json", "appdata", false, Settings::Format::JSON);
+        settings.setString("section.value1", "string");
+        settings.save();
+    }
+    {
+        Settings settings("parse_cache_damaged.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+    }
+    ASSERT_TRUE(std::filesystem::exists("appdata/parse_cache_damaged.json.cache"));
+
+    // A record count far larger than the file, after magic, version, modification time, size and hash
+    {
+        std::fstream cache("appdata/parse_cache_damaged.json.cache", std::ios::in | std::ios::out | std::ios::binary);
+        cache.seekp(32);
+        const std::string count(8, '\xff');
+        cache.write(count.data(), static_cast<std::streamsize>(count.size()));
+    }
+    auto before = Settings::cacheStatistics();
+    {
+        Settings settings("parse_cache_damaged.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+    }
+    EXPECT_EQ(Settings::cacheStatistics().misses - before.misses, 1U);
+}
+
+TEST(Settings, Parse_cache_disabled)
+{
+    std::filesystem::remove("appdata/parse_cache_disabled.json.cache");
+#ifdef _WIN32
+    _putenv_s(SETTINGS_CACHE_ENVIRONMENT_VARIABLE, "0");
+#else
+    setenv(SETTINGS_CACHE_ENVIRONMENT_VARIABLE, "0", 1);
+#endif
+    {
+        Settings settings("parse_cache_disabled.json", "appdata", false, Settings::Format::JSON);
+        settings.setString("section.value1", "string");
+        settings.save();
+    }
+    auto before = Settings::cacheStatistics();
+    {
+        Settings settings("parse_cache_disabled.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+    }
+    auto after = Settings::cacheStatistics();
+#ifdef _WIN32
+    _putenv_s(SETTINGS_CACHE_ENVIRONMENT_VARIABLE, "");
+#else
+    unsetenv(SETTINGS_CACHE_ENVIRONMENT_VARIABLE);
+#endif
+    EXPECT_FALSE(std::filesystem::exists("appdata/parse_cache_disabled.json.cache"));
+    EXPECT_EQ(after.misses, before.misses);
+    EXPECT_EQ(after.hits, before.hits);
+}
+
+TEST(Settings, Sharded_store)
+{
+    {
+        Settings settings("sharded.json", "appdata", false, Settings::Format::JSON, Settings::Store::Sharded);
+        std::vector<std::thread> writers;
+        for (int thread = 0; thread < 8; ++thread)
+        {
+            writers.emplace_back([&settings, thread]() {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    settings.setInt("thread" + std::to_string(thread) + ".counter", i);
+                    settings.setString("thread" + std::to_string(thread) + ".list[" + std::to_string(i % 12) + "]",
+                                       "value");
+                }
+            });
+        }
+        for (auto& writer : writers)
+        {
+            writer.join();
+        }
+        EXPECT_EQ(settings.getInt("thread3.counter"), 999);
+        EXPECT_THROW(settings.getInt("thread3.missing"), NotFoundException);
+        settings.save();
+    }
+
+    Settings settings("sharded.json", "appdata", false, Settings::Format::JSON);
+    settings.load();
+    for (int thread = 0; thread < 8; ++thread)
+    {
+        EXPECT_EQ(settings.getInt("thread" + std::to_string(thread) + ".counter"), 999);
+        EXPECT_EQ(settings.getString("thread" + std::to_string(thread) + ".list[11]"), "value");
+    }
+}
+
+TEST(Settings, Sharded_reload)
+{
+    auto write = [](int round) {
+        auto writer = openWriter("appdata/sharded_reload.json", Settings::Format::JSON);
+        for (int i = 0; i < 1000; ++i)
+        {
+            writer->write("section.key" + std::to_string(i), std::to_string(round));
+        }
+        writer->close();
+        std::filesystem::last_write_time("appdata/sharded_reload.json",
+                                         std::filesystem::file_time_type::clock::now() + std::chrono::seconds(round));
+    };
+    write(0);
+    Settings settings("sharded_reload.json", "appdata", false, Settings::Format::JSON, Settings::Store::Sharded);
+    settings.load();
+
+    // Every reload replaces the values in place, a reader never finds a key missing in between
+    std::atomic<bool> done{false};
+    std::atomic<int> missing{0};
+    std::thread reader([&settings, &done, &missing]() {
+        for (int i = 0; !done; i = (i + 1) % 1000)
+        {
+            if (!settings.exists("section.key" + std::to_string(i)))
+            {
+                ++missing;
+            }
+        }
+    });
+    for (int round = 1; round <= 20; ++round)
+    {
+        write(round);
+        settings.load();
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(missing, 0);
+    EXPECT_EQ(settings.getInt("section.key999"), 20);
+}
+
+TEST(Settings, Access_profile)
+{
+    std::filesystem::remove("appdata/profile.profile");
+    {
+        Settings settings("profile", "appdata", false, Settings::Format::Filesystem);
+        settings.setString("section.value1", "string");
+        settings.setInt("section.value2", 123);
+        settings.setBool("section.value3", true);
+        settings.save();
+
+        settings.recordAccessProfile();
+        EXPECT_EQ(settings.getInt("section.value2"), 123);
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+        EXPECT_EQ(settings.getInt("section.value2"), 123);
+        settings.saveAccessProfile();
+        EXPECT_EQ(settings.getBool("section.value3"), true);
+    }
+
+    std::ifstream file("appdata/profile.profile");
+    std::string first;
+    std::string second;
+    std::string third;
+    std::getline(file, first);
+    std::getline(file, second);
+    EXPECT_EQ(first, "section.value2");
+    EXPECT_EQ(second, "section.value1");
+    EXPECT_FALSE(std::getline(file, third));
+
+    auto before = Settings::warmedValues();
+    {
+        Settings settings("profile", "appdata", false, Settings::Format::Filesystem);
+        settings.load();
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+        EXPECT_EQ(settings.getInt("section.value2"), 123);
+        settings.setString("section.value1", "changed");
+        EXPECT_EQ(settings.getString("section.value1"), "changed");
+    }
+    // The destructor waits for the warming of both profiled keys
+    EXPECT_EQ(Settings::warmedValues() - before, 2U);
+
+    // A loaded file holds every value already, its profile is not warmed
+    {
+        Settings settings("profile.json", "appdata", false, Settings::Format::JSON);
+        settings.setString("section.value1", "string");
+        settings.save();
+        settings.recordAccessProfile();
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+        settings.saveAccessProfile();
+    }
+    before = Settings::warmedValues();
+    {
+        Settings settings("profile.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+    }
+    EXPECT_EQ(Settings::warmedValues(), before);
+}
+
+TEST(Settings, Streaming_save)
+{
+    auto read = [](const std::string& path) {
+        std::ifstream file(path);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+    {
+        Settings settings("streaming.json", "appdata", false, Settings::Format::JSON);
+        settings.setString("section.value1", "a \"quoted\" string");
+        settings.setInt("section.value2", -123);
+        settings.setDouble("section.value3", 0.1);
+        settings.setBool("section.value4", true);
+        settings.setString("section.version", "1.10");
+        settings.setString("section.code", "007");
+        settings.setString("section.flag", "true");
+        settings.save();
+    }
+
+    auto content = read("appdata/streaming.json");
+    EXPECT_NE(content.find(R"("value1": "a \"quoted\" string")"), std::string::npos);
+    EXPECT_NE(content.find(R"("value2": -123)"), std::string::npos);
+    EXPECT_NE(content.find(R"("value3": 0.1)"), std::string::npos);
+    EXPECT_NE(content.find(R"("value4": true)"), std::string::npos);
+    EXPECT_NE(content.find(R"("version": "1.10")"), std::string::npos);
+    EXPECT_NE(content.find(R"("code": "007")"), std::string::npos);
+    EXPECT_NE(content.find(R"("flag": "true")"), std::string::npos);
+
+    {
+        Settings settings("streaming.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+        EXPECT_EQ(settings.getString("section.value1"), "a \"quoted\" string");
+        EXPECT_EQ(settings.getInt("section.value2"), -123);
+        EXPECT_EQ(settings.getDouble("section.value3"), 0.1);
+        EXPECT_EQ(settings.getBool("section.value4"), true);
+        EXPECT_EQ(settings.getString("section.version"), "1.10");
+        settings.setString("section.value1", "changed");
+        settings.save();
+    }
+    // A load and a save keep the type of every value
+    content = read("appdata/streaming.json");
+    EXPECT_NE(content.find(R"("value2": -123)"), std::string::npos);
+    EXPECT_NE(content.find(R"("value4": true)"), std::string::npos);
+    EXPECT_NE(content.find(R"("version": "1.10")"), std::string::npos);
+    EXPECT_NE(content.find(R"("code": "007")"), std::string::npos);
+    EXPECT_NE(content.find(R"("flag": "true")"), std::string::npos);
+
+    {
+        Settings settings("streaming.xml", "appdata", false, Settings::Format::XML);
+        settings.setString("section[@name]", "first");
+        settings.setString("section.value1", "a <tagged> & \"quoted\" string");
+        settings.setInt("section.value2", -123);
+        settings.save();
+    }
+    content = read("appdata/streaming.xml");
+    EXPECT_EQ(content.substr(content.size() - 10), "</config>\n");
+    {
+        Settings settings("streaming.xml", "appdata", false, Settings::Format::XML);
+        settings.load();
+        EXPECT_EQ(settings.getString("section[@name]"), "first");
+        EXPECT_EQ(settings.getString("section.value1"), "a <tagged> & \"quoted\" string");
+        EXPECT_EQ(settings.getInt("section.value2"), -123);
+    }
+
+    {
+        Settings settings("streaming.properties", "appdata", false, Settings::Format::PropertyFile);
+        settings.setString("section.key with = and :", "first line\nsecond line");
+        settings.setInt("section.value2", -123);
+        settings.save();
+    }
+    {
+        Settings settings("streaming.properties", "appdata", false, Settings::Format::PropertyFile);
+        settings.load();
+        EXPECT_EQ(settings.getString("section.key with = and :"), "first line\nsecond line");
+        EXPECT_EQ(settings.getInt("section.value2"), -123);
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "config_daemon_stub.h"
+#include "exception.h"
+#include "settings.h"
+#include <chrono>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+using namespace project_library;
+
+namespace
+{
+
+void setDaemonAddress(const std::string& address)
+{
+#ifdef _WIN32
+    _putenv_s(CONFIG_DAEMON_ENVIRONMENT_VARIABLE, address.c_str());
+#else
+    setenv(CONFIG_DAEMON_ENVIRONMENT_VARIABLE, address.c_str(), 1);
+#endif
+}
+
+void setDaemonTimeout(const std::string& milliseconds)
+{
+#ifdef _WIN32
+    _putenv_s(CONFIG_DAEMON_TIMEOUT_ENVIRONMENT_VARIABLE, milliseconds.c_str());
+#else
+    setenv(CONFIG_DAEMON_TIMEOUT_ENVIRONMENT_VARIABLE, milliseconds.c_str(), 1);
+#endif
+}
+
+} // namespace
+
+TEST(SettingsDaemon, Load)
+{
+    ConfigDaemonStub daemon;
+    daemon.set("daemon_load", "section.value1", "string");
+    daemon.set("daemon_load", "section.value2", "123");
+    setDaemonAddress(daemon.address());
+
+    Settings settings("daemon_load", "", false, Settings::Format::Daemon);
+    settings.load();
+    EXPECT_EQ(settings.getString("section.value1"), "string");
+    EXPECT_EQ(settings.getInt("section.value2"), 123);
+    EXPECT_EQ(daemon.requests(), 1);
+}
+
+TEST(SettingsDaemon, Conditional_fetch)
+{
+    ConfigDaemonStub daemon;
+    daemon.set("daemon_fetch", "section.value1", "string");
+    setDaemonAddress(daemon.address());
+
+    Settings settings("daemon_fetch", "", false, Settings::Format::Daemon);
+    settings.load();
+    settings.load();
+    EXPECT_EQ(daemon.notModified(), 1);
+
+    daemon.set("daemon_fetch", "section.value1", "changed");
+    settings.load();
+    EXPECT_EQ(daemon.notModified(), 1);
+    EXPECT_EQ(settings.getString("section.value1"), "changed");
+}
+
+TEST(SettingsDaemon, Save)
+{
+    ConfigDaemonStub daemon;
+    daemon.set("daemon_save", "section.value1", "string");
+    setDaemonAddress(daemon.address());
+
+    Settings settings("daemon_save", "", false, Settings::Format::Daemon);
+    settings.load();
+    settings.setInt("section.value2", 123);
+    settings.setString("section.value3", "tab\tand\nline");
+    settings.save();
+    EXPECT_EQ(daemon.get("daemon_save", "section.value2"), "123");
+    EXPECT_EQ(daemon.get("daemon_save", "section.value3"), "tab\tand\nline");
+
+    // The document only holds our own changes, the cached copy is still current
+    settings.load();
+    EXPECT_EQ(daemon.notModified(), 1);
+    EXPECT_EQ(settings.getString("section.value3"), "tab\tand\nline");
+}
+
+TEST(SettingsDaemon, Save_after_other_client)
+{
+    ConfigDaemonStub daemon;
+    daemon.set("daemon_other", "section.value1", "string");
+    setDaemonAddress(daemon.address());
+
+    Settings settings("daemon_other", "", false, Settings::Format::Daemon);
+    settings.load();
+    daemon.set("daemon_other", "section.value1", "changed by another client");
+    settings.setInt("section.value2", 123);
+    settings.save();
+
+    // The cached copy misses the other change, the next load downloads it
+    settings.load();
+    EXPECT_EQ(daemon.notModified(), 0);
+    EXPECT_EQ(settings.getString("section.value1"), "changed by another client");
+    EXPECT_EQ(settings.getInt("section.value2"), 123);
+}
+
+TEST(SettingsDaemon, Daemon_address)
+{
+    ConfigDaemonStub first;
+    ConfigDaemonStub second;
+    first.set("daemon_address", "section.value1", "first");
+    second.set("daemon_address", "section.value1", "second");
+
+    setDaemonAddress(first.address());
+    Settings fromFirst("daemon_address", "", false, Settings::Format::Daemon);
+    fromFirst.load();
+    setDaemonAddress(second.address());
+    Settings fromSecond("daemon_address", "", false, Settings::Format::Daemon);
+    fromSecond.load();
+    EXPECT_EQ(fromFirst.getString("section.value1"), "first");
+    EXPECT_EQ(fromSecond.getString("section.value1"), "second");
+}
+
+TEST(SettingsDaemon, Missing_document)
+{
+    ConfigDaemonStub daemon;
+    setDaemonAddress(daemon.address());
+
+    Settings settings("daemon_missing", "", false, Settings::Format::Daemon);
+    EXPECT_THROW(settings.load(), FileNotFound);
+}
+
+TEST(SettingsDaemon, Stalled_daemon)
+{
+    ConfigDaemonStub daemon;
+    daemon.set("daemon_stalled", "section.value1", "string");
+    setDaemonAddress(daemon.address());
+    setDaemonTimeout("100");
+
+    Settings settings("daemon_stalled", "", false, Settings::Format::Daemon);
+    settings.load();
+    settings.setInt("section.value2", 123);
+    daemon.stall(std::chrono::milliseconds(500));
+    EXPECT_THROW(settings.save(), ConnectionError);
+    EXPECT_THROW(settings.load(), ConnectionError);
+    EXPECT_EQ(settings.getInt("section.value2"), 123);
+
+    // The stalled requests were dropped, the changes of the failed push are sent by the next one
+    daemon.stall(std::chrono::milliseconds(0));
+    settings.save();
+    EXPECT_EQ(daemon.get("daemon_stalled", "section.value2"), "123");
+    setDaemonTimeout("");
+}
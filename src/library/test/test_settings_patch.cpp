@@ -0,0 +1,96 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "settings.h"
+#include "settings_patch.h"
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+
+using namespace project_library;
+
+TEST(SettingsPatch, Diff_and_apply)
+{
+    Settings from("patch_from.json", "appdata", false, Settings::Format::JSON);
+    from.setString("section.value1", "string");
+    from.setInt("section.value2", 123);
+    from.setString("section.value3", "removed");
+
+    Settings to("patch_to.json", "appdata", false, Settings::Format::JSON);
+    to.setString("section.value1", "changed");
+    to.setInt("section.value2", 123);
+    to.setBool("section.value4", true);
+
+    auto patch = diff(from, to);
+    EXPECT_EQ(patch.size(), 3U);
+    EXPECT_EQ(patch.added.at("section.value4"), "true");
+    EXPECT_EQ(patch.changed.at("section.value1"), "changed");
+    ASSERT_EQ(patch.removed.size(), 1U);
+    EXPECT_EQ(patch.removed[0], "section.value3");
+
+    from.apply(patch);
+    EXPECT_EQ(from.getString("section.value1"), "changed");
+    EXPECT_EQ(from.getInt("section.value2"), 123);
+    EXPECT_EQ(from.getBool("section.value4"), true);
+    EXPECT_FALSE(from.exists("section.value3"));
+    EXPECT_TRUE(diff(from, to).empty());
+}
+
+TEST(SettingsPatch, Apply_keeps_types)
+{
+    Settings settings("patch_types.json", "appdata", false, Settings::Format::JSON);
+    settings.setInt("section.number", 1);
+    settings.setBool("section.flag", false);
+    settings.setString("section.text", "1");
+    settings.save();
+
+    SettingsPatch patch;
+    patch.changed["section.number"] = "2";
+    patch.changed["section.flag"] = "true";
+    patch.changed["section.text"] = "2";
+    patch.added["section.added"] = "3";
+    settings.apply(patch);
+    settings.save();
+
+    std::ifstream file("appdata/patch_types.json");
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find(R"("number": 2)"), std::string::npos) << content;
+    EXPECT_NE(content.find(R"("flag": true)"), std::string::npos) << content;
+    EXPECT_NE(content.find(R"("text": "2")"), std::string::npos) << content;
+    EXPECT_NE(content.find(R"("added": "3")"), std::string::npos) << content;
+}
+
+TEST(SettingsPatch, Serialize_and_parse)
+{
+    SettingsPatch patch;
+    patch.added["section.value1"] = "tab\tand\nline\\";
+    patch.changed["section.value2"] = "";
+    patch.removed.push_back("section.value3");
+
+    auto parsed = SettingsPatch::parse(patch.serialize());
+    EXPECT_EQ(parsed.added, patch.added);
+    EXPECT_EQ(parsed.changed, patch.changed);
+    EXPECT_EQ(parsed.removed, patch.removed);
+
+    EXPECT_THROW(SettingsPatch::parse("*section.value1\tvalue\n"), SyntaxException);
+}
+
+TEST(SettingsPatch, Diff_files)
+{
+    Settings from("patch_from.prop", "appdata", false, Settings::Format::PropertyFile);
+    from.setString("section.value1", "string");
+    from.setString("section.value2", "same");
+    from.save();
+
+    Settings to("patch_to.prop", "appdata", false, Settings::Format::PropertyFile);
+    to.setString("section.value1", "changed");
+    to.setString("section.value2", "same");
+    to.save();
+
+    auto patch = diff("appdata/patch_from.prop", "appdata/patch_to.prop", Settings::Format::PropertyFile);
+    EXPECT_EQ(patch.size(), 1U);
+    EXPECT_EQ(patch.changed.at("section.value1"), "changed");
+}
@@ -0,0 +1,202 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "settings.h"
+#include "settings_stream.h"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <map>
+#include <utility>
+
+using namespace project_library;
+
+namespace
+{
+
+std::map<std::string, std::string> readAll(const std::string& path, Settings::Format format)
+{
+    std::map<std::string, std::string> records;
+    openReader(path, format)->read(
+        [&records](const std::string& key, const std::string& value) { records[key] = value; });
+    return records;
+}
+
+void writeAll(const std::string& path, Settings::Format format, const std::map<std::string, std::string>& records)
+{
+    auto writer = openWriter(path, format);
+    for (const auto& [key, value] : records)
+    {
+        writer->write(key, value);
+    }
+    writer->close();
+}
+
+const std::map<std::string, std::string> sample = {{"section.value1", "string"},
+                                                   {"section.value2", "123"},
+                                                   {"section.value3", "321.123"},
+                                                   {"section.value4", "false"},
+                                                   {"section.escaped", "a \"quoted\" <value> & \\ tab\there"},
+                                                   {"other.list[0]", "first"},
+                                                   {"other.list[1]", "second"}};
+
+} // namespace
+
+TEST(SettingsStream, IniFile_read)
+{
+    auto records = readAll("appdata/settings.ini", Settings::Format::IniFile);
+    EXPECT_EQ(records["section.value1"], "string");
+    EXPECT_EQ(records["section.value2"], "123");
+    EXPECT_EQ(records["section.value3"], "321.123");
+    EXPECT_EQ(records["section.value4"], "false");
+}
+
+TEST(SettingsStream, IniFile_write)
+{
+    EXPECT_THROW(openWriter("appdata/stream.ini", Settings::Format::IniFile), NotImplemented);
+}
+
+TEST(SettingsStream, JSON_roundtrip)
+{
+    writeAll("appdata/stream.json", Settings::Format::JSON, sample);
+    EXPECT_EQ(readAll("appdata/stream.json", Settings::Format::JSON), sample);
+
+    Settings settings("stream.json", "appdata", false, Settings::Format::JSON);
+    settings.load();
+    EXPECT_EQ(settings.getString("section.value1"), "string");
+    EXPECT_EQ(settings.getInt("section.value2"), 123);
+    EXPECT_EQ(settings.getString("other.list[1]"), "second");
+}
+
+TEST(SettingsStream, JSON_typed_roundtrip)
+{
+    {
+        std::ofstream file("appdata/typed.json");
+        file << R"({"section": {"text": "123", "flag": "true", "number": 123, "enabled": true}})";
+    }
+
+    // The same copy settings-convert does, the strings that read as literals keep their quotes
+    auto writer = openWriter("appdata/typed_copy.json", Settings::Format::JSON);
+    openReader("appdata/typed.json", Settings::Format::JSON)
+        ->readTyped([&writer](const std::string& key, const std::string& value, bool literal) {
+            writer->writeTyped(key, value, literal);
+        });
+    writer->close();
+
+    std::map<std::string, std::pair<std::string, bool>> records;
+    openReader("appdata/typed_copy.json", Settings::Format::JSON)
+        ->readTyped([&records](const std::string& key, const std::string& value, bool literal) {
+            records[key] = {value, literal};
+        });
+    EXPECT_EQ(records["section.text"], std::make_pair(std::string("123"), false));
+    EXPECT_EQ(records["section.flag"], std::make_pair(std::string("true"), false));
+    EXPECT_EQ(records["section.number"], std::make_pair(std::string("123"), true));
+    EXPECT_EQ(records["section.enabled"], std::make_pair(std::string("true"), true));
+}
+
+TEST(SettingsStream, XML_roundtrip)
+{
+    writeAll("appdata/stream.xml", Settings::Format::XML, sample);
+    auto records = readAll("appdata/stream.xml", Settings::Format::XML);
+    EXPECT_EQ(records["section.value1"], "string");
+    EXPECT_EQ(records["section.escaped"], sample.at("section.escaped"));
+    EXPECT_EQ(records["other.list"], "first");
+    EXPECT_EQ(records["other.list[1]"], "second");
+
+    Settings settings("stream.xml", "appdata", false, Settings::Format::XML);
+    settings.load();
+    EXPECT_EQ(settings.getDouble("section.value3"), 321.123);
+    EXPECT_EQ(settings.getString("other.list[1]"), "second");
+}
+
+TEST(SettingsStream, XML_document)
+{
+    const std::map<std::string, std::string> records = {{"server[@port]", "8080"},
+                                                        {"server.name", "first"},
+                                                        {"server[1].name", "second"},
+                                                        {"section.value1", "string"}};
+    auto writer = openWriter("appdata/document.xml", Settings::Format::XML);
+    for (const auto& key : {"server[@port]", "server.name", "server[1].name", "section.value1"})
+    {
+        writer->write(key, records.at(key));
+    }
+    writer->close();
+
+    std::ifstream file("appdata/document.xml");
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content.substr(content.size() - 10), "</config>\n");
+    EXPECT_EQ(readAll("appdata/document.xml", Settings::Format::XML), records);
+}
+
+TEST(SettingsStream, PropertyFile_roundtrip)
+{
+    writeAll("appdata/stream.prop", Settings::Format::PropertyFile, sample);
+    EXPECT_EQ(readAll("appdata/stream.prop", Settings::Format::PropertyFile), sample);
+}
+
+TEST(SettingsStream, PropertyFile_keys)
+{
+    const std::map<std::string, std::string> records = {{"key with spaces ", "1"},
+                                                        {"key:with=separators", "2"},
+                                                        {"#not a comment", "3"},
+                                                        {"!neither", "4"},
+                                                        {"back\\slash", "5"}};
+    writeAll("appdata/keys.prop", Settings::Format::PropertyFile, records);
+    EXPECT_EQ(readAll("appdata/keys.prop", Settings::Format::PropertyFile), records);
+}
+
+TEST(SettingsStream, Unordered_records)
+{
+    auto reopened = openWriter("appdata/unordered", Settings::Format::JSON);
+    reopened->write("a.x", "1");
+    reopened->write("b.y", "2");
+    EXPECT_THROW(reopened->write("b", "3"), SyntaxException);
+
+    auto repeated = openWriter("appdata/unordered", Settings::Format::XML);
+    repeated->write("a.x", "1");
+    repeated->write("a[1].y", "2");
+    EXPECT_THROW(repeated->write("a.z", "3"), SyntaxException);
+
+    for (auto format : {Settings::Format::JSON, Settings::Format::XML})
+    {
+        auto skipped = openWriter("appdata/unordered", format);
+        skipped->write("list[0]", "1");
+        EXPECT_THROW(skipped->write("list[5]", "2"), SyntaxException);
+    }
+}
+
+TEST(SettingsStream, Filesystem_roundtrip)
+{
+    writeAll("appdata/stream", Settings::Format::Filesystem, {{"section.value1", "string"}, {"section.value2", "123"}});
+    auto records = readAll("appdata/stream", Settings::Format::Filesystem);
+    EXPECT_EQ(records["section.value1"], "string");
+    EXPECT_EQ(records["section.value2"], "123");
+}
+
+TEST(SettingsStream, JSON_syntax_error)
+{
+    writeAll("appdata/broken.prop", Settings::Format::PropertyFile, {{"key", "value"}});
+    EXPECT_THROW(readAll("appdata/broken.prop", Settings::Format::JSON), SyntaxException);
+}
+
+TEST(SettingsStream, Missing_file)
+{
+    EXPECT_THROW(openReader("appdata/missing.json", Settings::Format::JSON), FileNotFound);
+}
+
+TEST(SettingsStream, Compressed_detected_by_magic)
+{
+    writeAll("appdata/packed.xml.gz", Settings::Format::XML, sample);
+    std::remove("appdata/packed.xml");
+    ASSERT_EQ(std::rename("appdata/packed.xml.gz", "appdata/packed.xml"), 0);
+
+    EXPECT_EQ(readAll("appdata/packed.xml", Settings::Format::XML)["section.value1"], "string");
+
+    Settings settings("packed.xml", "appdata", false, Settings::Format::XML);
+    settings.load();
+    EXPECT_EQ(settings.getString("other.list[1]"), "second");
+}
@@ -0,0 +1,60 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "settings.h"
+#include "trace.h"
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace project_library;
+
+TEST(Trace, Load_and_save_phases)
+{
+    // The variable is read once, before the first event of the process
+#ifdef _WIN32
+    _putenv_s(TRACE_ENVIRONMENT_VARIABLE, "appdata/trace_events.json");
+#else
+    setenv(TRACE_ENVIRONMENT_VARIABLE, "appdata/trace_events.json", 1);
+#endif
+    ASSERT_TRUE(traceEnabled());
+
+    {
+        Settings settings("trace.json", "appdata", false, Settings::Format::JSON);
+        settings.setString("section.value1", "string");
+        settings.save();
+    }
+    {
+        Settings settings("trace.json", "appdata", false, Settings::Format::JSON);
+        settings.load();
+        // More events than a batch, the trace file is written while they are recorded
+        for (int i = 0; i < 100000; ++i)
+        {
+            settings.getString("section.value1");
+        }
+        EXPECT_EQ(settings.getString("section.value1"), "string");
+    }
+    traceFlush();
+
+    std::ifstream file("appdata/trace_events.json");
+    std::stringstream content;
+    content << file.rdbuf();
+    auto trace = content.str();
+    for (const auto* phase : {"factory", "resolve path", "create folders", "serialize", "save", "stat", "open", "read",
+                              "parse", "store cache", "load", "get"})
+    {
+        EXPECT_NE(trace.find(std::string(R"("name":")") + phase + '"'), std::string::npos) << phase;
+    }
+    const std::string get = R"("name":"get")";
+    std::size_t gets = 0;
+    for (auto pos = trace.find(get); pos != std::string::npos; pos = trace.find(get, pos + 1))
+    {
+        ++gets;
+    }
+    EXPECT_GE(gets, 100001U);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+}
@@ -0,0 +1,115 @@
+/**
+ * Part of https://github.com/ManelJimeno/bootstrap (C) 2022
+ * Authors: Manel Jimeno <manel.jimeno@gmail.com>
+ * License: http://www.opensource.org/licenses/mit-license.php MIT
+ */
+
+#include "Poco/File.h"
+#include "Poco/Path.h"
+#include "Poco/TemporaryFile.h"
+#include "settings_stream.h"
+#include <chrono>
+#include <iostream>
+#include <map>
+
+using namespace project_library;
+
+namespace
+{
+
+const std::map<std::string, Settings::Format> formats = {{"filesystem", Settings::Format::Filesystem},
+                                                         {"json", Settings::Format::JSON},
+                                                         {"ini", Settings::Format::IniFile},
+                                                         {"xml", Settings::Format::XML},
+                                                         {"properties", Settings::Format::PropertyFile}};
+
+void usage()
+{
+    std::cerr << "Usage: settings-convert <input> <input format> <output> <output format>\n"
+              << "Formats: filesystem, json, ini (input only), xml, properties\n"
+              << "The records are converted as they are read, a json or xml output needs the keys of a section "
+                 "together\nand the items of a list in order from 0, xml can not be converted to json\n";
+}
+
+void removeFile(const std::string& path)
+{
+    try
+    {
+        Poco::File(path).remove();
+    }
+    catch (Poco::Exception&)
+    {
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc != 5 || formats.count(argv[2]) == 0 || formats.count(argv[4]) == 0)
+    {
+        usage();
+        return 1;
+    }
+    std::string input(argv[1]);
+    std::string output(argv[3]);
+    auto inputFormat = formats.at(argv[2]);
+    auto outputFormat = formats.at(argv[4]);
+    if (inputFormat == Settings::Format::XML && outputFormat == Settings::Format::JSON)
+    {
+        // The attribute keys and the repeated elements of a xml document have no json member to be written to
+        std::cerr << "settings-convert: xml can not be converted to json, its attributes and repeated elements have "
+                     "no json key\n";
+        return 1;
+    }
+
+    // A file is written next to the output and renamed when complete, a failure leaves the previous output as it was
+    std::string temporary;
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        auto reader = openReader(input, inputFormat);
+        std::string target = output;
+        if (outputFormat != Settings::Format::Filesystem)
+        {
+            // Ends with the name of the output, a '.gz' suffix still compresses it
+            Poco::Path path(Poco::Path(output).absolute());
+            temporary = Poco::TemporaryFile::tempName(path.parent().toString()) + "-" + path.getFileName();
+            target = temporary;
+        }
+        auto writer = openWriter(target, outputFormat);
+        std::size_t records = 0;
+        std::size_t recordBytes = 0;
+        reader->readTyped(
+            [&writer, &records, &recordBytes](const std::string& key, const std::string& value, bool literal) {
+                writer->writeTyped(key, value, literal);
+                ++records;
+                recordBytes += key.size() + value.size();
+            });
+        writer->close();
+        writer.reset();
+        if (!temporary.empty())
+        {
+            Poco::File(temporary).renameTo(output);
+            temporary.clear();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        Poco::File inputFile(input);
+        auto bytes = inputFile.isFile() ? static_cast<double>(inputFile.getSize()) : static_cast<double>(recordBytes);
+        auto seconds = elapsed.count();
+        std::cout << "Converted " << records << " keys (" << bytes / 1e6 << " MB) in " << seconds << " s: "
+                  << (seconds > 0 ? bytes / 1e6 / seconds : 0) << " MB/s\n";
+    }
+    catch (std::exception& e)
+    {
+        if (!temporary.empty())
+        {
+            removeFile(temporary);
+        }
+        std::cerr << "settings-convert: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}